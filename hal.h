@@ -28,3 +28,12 @@ void jtag_tms_write(int level);   // mode select, 0/1
 void jtag_tdi_write(int level);   // data to target, 0/1
 int  jtag_tdo_read(void);         // data from target, returns 0/1
 #endif
+
+// SWO capture on a second UART (optional, C1105 only). Received bytes are queued by
+// the RX interrupt; swo_getc() drains them from the main loop.
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+int      swo_uart_start(uint32_t baud);  // returns 0 if the baud rate is out of range
+void     swo_uart_stop(void);
+int      swo_getc(void);                 // returns 0..255, or -1 if nothing is queued
+uint32_t swo_uart_dropped(void);         // bytes lost to a full queue or RX FIFO overrun
+#endif
@@ -44,8 +44,72 @@ bool cortex_write_core_reg(uint32_t regnum, uint32_t v);
 void cortex_breakpoints_init(void);
 bool cortex_breakpoint_insert(uint32_t addr);
 bool cortex_breakpoint_remove(uint32_t addr);
+bool cortex_breakpoint_at(uint32_t addr);
+
+// Software breakpoints (PROBE_ENABLE_SW_BREAKPOINTS): when the FPB is exhausted,
+// RAM-resident code gets a patched BKPT. These keep the patches invisible to
+// memory reads and intact across memory writes that overlap them.
+void cortex_sw_breakpoints_mask_read(uint32_t addr, uint8_t *buf, uint32_t len);
+void cortex_sw_breakpoints_after_write(uint32_t addr, const uint8_t *buf, uint32_t len);
 
 bool cortex_watchpoints_supported(void);
 bool cortex_watchpoint_insert(cortexm_watch_t type, uint32_t addr, uint32_t len);
 bool cortex_watchpoint_remove(cortexm_watch_t type, uint32_t addr, uint32_t len);
 bool cortex_watchpoint_hit(cortexm_watch_t *out_type, uint32_t *out_addr);
+// True if the last cortex_watchpoint_hit() saw only DWT matches that the
+// probe-side filter rejected (masked range write that left the range unchanged,
+// or a value condition the probe had to check itself).
+bool cortex_watchpoint_filtered(void);
+
+// PC sampling (PROBE_ENABLE_PROFILE): DWT_PCSR while running, or a brief
+// halt/read PC/resume on cores without PCSR. False if no sample was taken.
+bool cortex_sample_pc(uint32_t *out);
+
+// DWT profiling counters (PROBE_ENABLE_PERF_COUNTERS), v7-M/v8-M mainline only.
+// Index 0 is CYCCNT (32-bit); 1..5 are the 8-bit CPI/EXC/SLEEP/LSU/FOLD counters.
+#define CORTEX_PERF_NUM 6u
+bool cortex_perf_enable(bool on);
+bool cortex_perf_read(uint32_t out[CORTEX_PERF_NUM]);
+
+// DWT_CYCCNT, enabled on first use (PROBE_ENABLE_REGION_TIMING). False on cores without it.
+bool cortex_cycle_count(uint32_t *out);
+
+// SWO trace (PROBE_ENABLE_SWO), v7-M/v8-M mainline only: TPIU in NRZ mode with the
+// given ACPR prescaler, ITM stimulus ports in port_mask, DWT exception trace if asked.
+bool cortex_swo_enable(uint32_t prescaler, uint32_t port_mask, bool exc_trace);
+bool cortex_swo_disable(void);
+
+// Semihosting (PROBE_ENABLE_SEMIHOSTING): halted on `BKPT 0xAB`? op = r0, arg = r1.
+// Return sets r0 and steps the PC over the BKPT.
+bool cortex_semihost_pending(uint32_t *out_op, uint32_t *out_arg);
+bool cortex_semihost_return(uint32_t result);
+
+// Calls into code in target RAM (helper stubs, flash algorithms; PROBE_ENABLE_TARGET_STUBS or
+// PROBE_ENABLE_FLASH). begin needs a halted core: it saves r0-r15/xPSR and arms the HardFault
+// vector catch, end restores both. start sets r0-r3 = args, r9 = sb, sp and lr = ret (a BKPT)
+// and resumes at entry with interrupts masked; wait returns r0 once the core is back at ret,
+// or halts it and returns false on a fault or timeout.
+bool cortex_call_begin(void);
+bool cortex_call_start(uint32_t entry, const uint32_t args[4], uint32_t sb, uint32_t sp, uint32_t ret);
+bool cortex_call_wait(uint32_t timeout_us, uint32_t *out_r0);
+bool cortex_call_end(void);
+
+// Target-resident helper stubs (PROBE_ENABLE_TARGET_STUBS). A small Thumb routine is
+// copied into a scratch RAM window and run on the halted core, with interrupts masked,
+// until it reaches its BKPT; the window bytes and the registers it used are restored
+// afterwards. set_ram(addr, 0) disables them; windows are capped at CORTEX_STUB_RAM_MAX.
+// All return false when no window is set, the core isn't halted, the range overlaps the
+// window or fails an SWD probe, or the stub faulted or timed out; callers then do the
+// work over SWD (unless cortex_stub_faulted()).
+#define CORTEX_STUB_RAM_MAX 256u
+bool cortex_stub_set_ram(uint32_t addr, uint32_t size);
+bool cortex_stub_get_ram(uint32_t *out_addr, uint32_t *out_size);
+bool cortex_stub_memset(uint32_t addr, uint8_t value, uint32_t len);
+// GDB CRC-32 (crc32.h) over [addr, addr+len), continuing from *io_crc.
+bool cortex_stub_crc32(uint32_t addr, uint32_t len, uint32_t *io_crc);
+// First occurrence of pat in [addr, addr+len); the pattern shares the window with the code.
+bool cortex_stub_search(uint32_t addr, uint32_t len, const uint8_t *pat, uint32_t plen, bool *out_found,
+                        uint32_t *out_addr);
+// True if the last call above failed because the stub faulted. The target is then left
+// with a HardFault active and needs a reset; callers report that instead of falling back.
+bool cortex_stub_faulted(void);
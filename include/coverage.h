@@ -0,0 +1,36 @@
+#pragma once
+
+// On-probe code coverage from the MTB (PROBE_ENABLE_MTB_COVERAGE). The MTB runs in
+// watermark-halt mode; on every halt rsp_poll calls coverage_on_halt(), which folds
+// the straight-line runs between branches (destination of one packet to the source
+// of the next) into a bitmap over [base, base + size) and resumes watermark halts.
+// Each bit covers 2^shift bytes.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef COVERAGE_BITMAP_BYTES
+#define COVERAGE_BITMAP_BYTES 256u
+#endif
+
+typedef struct {
+    uint32_t base;
+    uint32_t size;
+    uint32_t shift;
+    uint32_t granules;   // bits in use
+    uint32_t covered;    // bits set
+    uint32_t drains;     // halts whose trace was folded in
+    uint32_t packets;
+    uint32_t overflows;  // drains that found the window wrapped (trace lost)
+    uint32_t dropped;    // runs rejected as implausible (backwards or over 64KB)
+} coverage_stats_t;
+
+// shift 0 picks the smallest granule that fits the range into the bitmap.
+bool coverage_start(uint32_t base, uint32_t size, uint32_t shift);
+void coverage_stop(void);
+bool coverage_active(void);
+// True if the halt was a watermark drain and the target was resumed.
+bool coverage_on_halt(void);
+void coverage_get(coverage_stats_t *out);
+// Iterate covered address ranges (inclusive); start with *cursor = 0.
+bool coverage_next_range(uint32_t *cursor, uint32_t *out_begin, uint32_t *out_end);
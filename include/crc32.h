@@ -0,0 +1,10 @@
+#pragma once
+
+// CRC-32 as GDB computes it for qCRC: polynomial 0x04C11DB7, MSB first, no reflection
+// and no final XOR. Start with CRC32_INIT and feed the data in any number of pieces.
+
+#include <stdint.h>
+
+#define CRC32_INIT 0xFFFFFFFFu
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *buf, uint32_t len);
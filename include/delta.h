@@ -0,0 +1,23 @@
+#pragma once
+
+// Delta reads (PROBE_ENABLE_DELTA_READ): registered regions are split into
+// DELTA_BLOCK-byte blocks and the probe keeps a CRC-32 of each block as last sent to
+// the host. A scan reads every block over SWD/SBA but reports only blocks whose CRC
+// differs, so unchanged memory costs no UART bytes. A block's CRC is only updated
+// once the caller commits it, so blocks that didn't fit in a reply come up again.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DELTA_BLOCK       32u
+#define DELTA_MAX_REGIONS 4u
+#define DELTA_MAX_BLOCKS  128u  // shared by all regions (4 KB at DELTA_BLOCK = 32)
+
+bool delta_add(uint32_t addr, uint32_t len, uint32_t *out_id);
+void delta_clear(void);
+// Find the next changed block of region id at or after *io_block; its bytes go to
+// data (up to DELTA_BLOCK) and their count to *out_len. Returns 1 if one was found,
+// 0 when the region is done, -1 on a bad id or failed read.
+int  delta_next(uint32_t id, uint32_t *io_block, uint8_t *data, uint32_t *out_len);
+// Record the block delta_next() just returned as sent.
+void delta_commit(uint32_t id, uint32_t block);
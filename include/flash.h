@@ -0,0 +1,46 @@
+#pragma once
+
+// Flash programming through an algorithm in target RAM (GDB vFlashErase/vFlashWrite/
+// vFlashDone). The algorithm uses the CMSIS FLM calling convention: Init(adr, clk, fnc),
+// UnInit(fnc), EraseSector(adr) and ProgramPage(adr, sz, buf), each returning 0 on success.
+// It is loaded into target RAM by the user and described with `monitor flash`; the probe
+// then serves a GDB memory map, so `load` switches to the vFlash packets.
+//
+// Pages are staged in two buffers in the RAM work area: while the target programs one,
+// the probe fills the other from the next vFlashWrite packets.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t start;     // flash region
+    uint32_t size;
+    uint32_t sector;    // erase unit, a power of two
+    uint32_t page;      // ProgramPage() unit, a power of two <= sector
+    uint32_t init;      // algorithm entry points (absolute, in target RAM)
+    uint32_t uninit;
+    uint32_t erase;
+    uint32_t program;
+    uint32_t sb;        // static base, passed in r9
+    uint32_t ram;       // work area: return BKPT, two page buffers, then the stack
+    uint32_t ram_size;
+} flash_config_t;
+
+bool flash_set_region(uint32_t start, uint32_t size, uint32_t sector, uint32_t page);
+bool flash_set_algo(uint32_t init, uint32_t uninit, uint32_t erase, uint32_t program, uint32_t sb);
+bool flash_set_ram(uint32_t addr, uint32_t size);
+// Copies the settings; true once they are complete and the work area fits two pages.
+bool flash_get_config(flash_config_t *out);
+// Smallest work area for a page size.
+uint32_t flash_ram_needed(uint32_t page);
+
+// The GDB packets. A failed call drops the session and restores the core registers.
+bool flash_erase(uint32_t addr, uint32_t len);
+bool flash_write(uint32_t addr, const uint8_t *data, uint32_t len);
+bool flash_done(void);
+// Drop an unfinished session (GDB detached): halt the algorithm and restore the core.
+void flash_abort(void);
+
+// GDB memory map document (qXfer:memory-map:read), in slices: the flash region, with RAM
+// on both sides so the rest of the address space stays accessible.
+bool flash_memory_map_read(uint32_t off, char *out, uint32_t len, uint32_t *out_len, bool *out_more);
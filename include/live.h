@@ -0,0 +1,35 @@
+#pragma once
+
+// Live watch streaming (PROBE_ENABLE_LIVE_WATCH): while the target runs, rsp_poll calls
+// live_poll(), which reads a list of regions at a fixed rate (MEM-AP on Cortex-M, SBA
+// on RISC-V) and sends one timestamped frame per sample as an `O` console packet:
+//
+//   L <time_us> <hex region 0> <hex region 1> ...\n
+//
+// time_us is hex, counted from live_start(). The rate is capped at what the GDB UART
+// can carry for the configured frame size; late samples are skipped, not queued.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LIVE_MAX_REGIONS 8u
+#define LIVE_MAX_BYTES   64u  // sum of all region lengths
+
+typedef struct {
+    bool     running;
+    uint32_t regions;
+    uint32_t bytes;      // per frame
+    uint32_t rate_hz;    // effective rate (requested, capped by the UART)
+    uint32_t frames;
+    uint32_t skipped;    // sample periods missed because the probe was busy
+    uint32_t errors;     // frames not sent because a read failed
+} live_stats_t;
+
+bool live_add(uint32_t addr, uint32_t len);
+void live_clear(void);
+bool live_region(uint32_t i, uint32_t *out_addr, uint32_t *out_len);
+bool live_start(uint32_t rate_hz);
+void live_stop(void);
+// Call while the target is running.
+void live_poll(void);
+void live_get(live_stats_t *out);
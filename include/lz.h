@@ -0,0 +1,40 @@
+#pragma once
+
+// Small byte-oriented LZ77 codec for compressed memory transfers. The stream is a
+// sequence of tokens:
+//
+//   0x00..0x7F  literal run: the next (t + 1) bytes are copied as-is
+//   0x80..0xFF  match: one more byte d follows; copy (t & 0x7F) + 3 bytes starting
+//               (d + 1) bytes back in the output (the copy may overlap itself, so
+//               distance 1 repeats one byte and distance 4 repeats a word)
+//
+// The stream carries no length or end marker: the receiver knows how many bytes it
+// asked for. Matches reach back at most 256 bytes, so either side needs only a
+// 256-byte window.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LZ_WINDOW    256u
+#define LZ_MIN_MATCH 3u
+#define LZ_MAX_MATCH (0x7Fu + LZ_MIN_MATCH)
+#define LZ_MAX_RUN   0x80u
+
+// Compressed read (PROBE_ENABLE_COMPRESSED_READ): target memory [addr, addr + len) is
+// read block by block and compressed on the fly. lz_read_peek() returns the next
+// compressed byte without consuming it, -1 at the end of the stream, or -2 if a
+// target read failed.
+void lz_read_start(uint32_t addr, uint32_t len);
+bool lz_read_matches(uint32_t addr, uint32_t len, uint32_t offset);
+int  lz_read_peek(void);
+void lz_read_skip(void);
+
+// Compressed write (PROBE_ENABLE_COMPRESSED_WRITE): a stream for [addr, addr + len) is
+// fed in arbitrary pieces (tokens may straddle them); decoded bytes are staged in the
+// 256-byte history window and written to the target in bursts of up to half of it.
+// Each lz_write_feed() writes out everything decoded so far before returning. False
+// on a malformed stream, output past len, or a failed target write.
+void     lz_write_start(uint32_t addr, uint32_t len);
+bool     lz_write_matches(uint32_t addr, uint32_t len, uint32_t offset);
+bool     lz_write_feed(const uint8_t *data, uint32_t n);
+uint32_t lz_write_done(void);  // bytes written to the target so far
@@ -0,0 +1,10 @@
+#pragma once
+
+// GDB `monitor` commands, delivered by the qRcmd packet.
+
+#include <stdbool.h>
+
+// Run one command line (already hex-decoded, NUL-terminated; modified in place).
+// Output goes to the GDB console via rsp_console_write(). Returns false if the
+// command is unknown or its arguments are invalid (a message has been printed).
+bool monitor_command(char *line);
@@ -0,0 +1,47 @@
+#pragma once
+
+// Micro Trace Buffer (CoreSight MTB-M0+). While enabled, the core writes every taken
+// branch as a (source, destination) word pair into a power-of-two window of its own
+// SRAM. The probe programs POSITION/MASTER/FLOW and, once the target has halted, reads
+// the circular buffer back for GDB branch trace (Qbtrace:bts, qXfer:btrace:read).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t base;       // MTB registers, 0 if none was found
+    uint32_t sram_base;  // MTB_BASE: SRAM address that POSITION offsets are relative to
+    uint32_t window;     // trace window start, 0 if none is configured
+    uint32_t size;       // trace window size in bytes
+    uint32_t position;   // current POSITION register (pointer | WRAP)
+    bool     enabled;
+} mtb_info_t;
+
+// Locate the MTB through the MEM-AP ROM table (done lazily by the calls below).
+bool mtb_discover(void);
+// Override discovery for parts whose ROM table doesn't list the MTB.
+void mtb_set_base(uint32_t base);
+// Trace window in target SRAM: size is a power of two (>= 16 bytes) and addr is
+// size-aligned relative to MTB_BASE. Firmware must leave this RAM alone. Without a
+// window, mtb_enable() adopts one the firmware already enabled itself.
+bool mtb_set_window(uint32_t addr, uint32_t size);
+// Branch trace mode; fails while coverage mode owns the MTB.
+bool mtb_enable(void);
+void mtb_disable(void);
+bool mtb_enabled(void);
+bool mtb_get_info(mtb_info_t *out);
+
+// Coverage mode (PROBE_ENABLE_MTB_COVERAGE): FLOW.AUTOHALT halts the core when the
+// trace reaches three quarters of the window. mtb_drain() passes every packet recorded
+// since the last drain to fn, oldest first (gap is set on the first one if the buffer
+// wrapped and older packets were lost), then restarts the window. *out_watermark says
+// whether the watermark caused the halt; the caller resumes the target.
+typedef void (*mtb_packet_fn)(uint32_t src, uint32_t dst, bool gap);
+bool mtb_enable_autohalt(void);
+bool mtb_drain(mtb_packet_fn fn, bool *out_watermark);
+
+// GDB btrace documents, served in slices. A read at offset 0 of the trace snapshots
+// the MTB write pointer and PC; later slices render from that snapshot. Copies up to
+// len bytes into out; *out_more is true while the document continues.
+bool mtb_btrace_read(uint32_t off, char *out, uint32_t len, uint32_t *out_len, bool *out_more);
+bool mtb_btrace_conf_read(uint32_t off, char *out, uint32_t len, uint32_t *out_len, bool *out_more);
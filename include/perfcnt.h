@@ -0,0 +1,25 @@
+#pragma once
+
+// DWT event counter sampling (Cortex-M v7-M/v8-M mainline). While the target runs,
+// rsp_poll calls perfcnt_poll(), which reads CYCCNT and the 8-bit CPI/EXC/SLEEP/
+// LSU/FOLD counters and folds the (mod 256) deltas into 32-bit totals.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PERFCNT_NUM 6u  // CYC, CPI, EXC, SLEEP, LSU, FOLD
+
+typedef struct {
+    uint32_t total[PERFCNT_NUM];
+    uint8_t  max_delta[PERFCNT_NUM];  // largest per-poll step of each 8-bit counter
+    uint32_t elapsed_ms;              // running time covered by the totals
+    uint32_t polls;
+} perfcnt_stats_t;
+
+bool perfcnt_start(uint32_t period_us);
+void perfcnt_stop(void);
+bool perfcnt_running(void);
+// Call on every rsp_poll pass. While halted, only notes that the counters stopped, so
+// the wall-clock gap across the halt isn't counted as running time.
+void perfcnt_poll(bool halted);
+void perfcnt_get(perfcnt_stats_t *out);
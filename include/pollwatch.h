@@ -0,0 +1,17 @@
+#pragma once
+
+// Background polled value watch: while the target runs, the probe samples one word
+// of target memory (MEM-AP on Cortex-M, SBA on RISC-V) and halts the target when
+// (word & mask) == value. Not cycle-exact, but needs no comparators and doesn't
+// slow the target down.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool pollwatch_set(uint32_t addr, uint32_t value, uint32_t mask, uint32_t period_us);
+void pollwatch_clear(void);
+bool pollwatch_get(uint32_t *out_addr, uint32_t *out_value, uint32_t *out_mask, uint32_t *out_period_us);
+
+// Call while the target is running. Returns true after halting the target on a
+// match; out_addr is the watched address.
+bool pollwatch_poll(uint32_t *out_addr);
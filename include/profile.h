@@ -0,0 +1,22 @@
+#pragma once
+
+// PC sampling profiler. While the target runs, rsp_poll calls profile_poll(), which
+// takes one PC sample per period (target_sample_pc) and bins it by (pc >> shift) in
+// a small open-addressed hash table. Samples that find the table full are counted
+// but not binned.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool profile_start(uint32_t period_us, uint32_t shift);
+void profile_stop(void);
+void profile_clear(void);
+bool profile_enabled(void);
+uint32_t profile_shift(void);
+
+void profile_poll(void);
+
+// samples: binned + unbinned; missed: periods where no PC could be read.
+void profile_totals(uint32_t *out_samples, uint32_t *out_missed, uint32_t *out_unbinned);
+// rank 0 = hottest bin. Returns false past the last non-empty bin.
+bool profile_top(uint32_t rank, uint32_t *out_addr, uint32_t *out_count);
@@ -0,0 +1,33 @@
+#pragma once
+
+// Region timing: breakpoints at a start and an end address; each time the target
+// stops there the probe snapshots the cycle counter (target_cycle_count) and
+// resumes on its own, accumulating min/max/mean over N start->end passes. GDB only
+// sees the final stop at the end address.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    REGIONTIME_NOT_MINE = 0,  // stop unrelated to timing; report it to GDB
+    REGIONTIME_RESUMED,       // consumed and target resumed
+    REGIONTIME_DONE,          // all iterations done; target halted at the end address
+} regiontime_status_t;
+
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint32_t iterations;  // requested passes
+    uint32_t count;       // completed passes
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+} regiontime_stats_t;
+
+// Target must be halted. Installs the two breakpoints and checks for a cycle counter.
+bool regiontime_start(uint32_t start, uint32_t end, uint32_t iterations);
+void regiontime_stop(void);
+bool regiontime_active(void);
+// Call from rsp_poll after the target halted while a timing run is active.
+regiontime_status_t regiontime_on_halt(void);
+bool regiontime_stats(regiontime_stats_t *out);
@@ -48,12 +48,31 @@ bool riscv_mem_write(uint32_t addr, const uint8_t *buf, uint32_t len);
 // Returns GDB signal number (e.g., 5 for SIGTRAP).
 uint8_t riscv_stop_reason(void);
 
-// Hardware breakpoints via trigger module.
+// Hardware breakpoints via trigger module. With PROBE_ENABLE_SW_BREAKPOINTS,
+// falls back to patching ebreak/c.ebreak into RAM once triggers run out.
 bool riscv_breakpoint_insert(uint32_t addr);
 bool riscv_breakpoint_remove(uint32_t addr);
+bool riscv_breakpoint_at(uint32_t addr);
+
+// Keep patched ebreaks invisible to memory reads and intact across writes.
+void riscv_sw_breakpoints_mask_read(uint32_t addr, uint8_t *buf, uint32_t len);
+void riscv_sw_breakpoints_after_write(uint32_t addr, const uint8_t *buf, uint32_t len);
 
 // Hardware watchpoints via trigger module.
 bool riscv_watchpoints_supported(void);
 bool riscv_watchpoint_insert(target_watch_t type, uint32_t addr, uint32_t len);
 bool riscv_watchpoint_remove(target_watch_t type, uint32_t addr, uint32_t len);
 bool riscv_watchpoint_hit(target_watch_t *out_type, uint32_t *out_addr);
+// True if the last halt only came from watches whose value condition didn't match.
+bool riscv_watchpoint_filtered(void);
+
+// PC sampling (PROBE_ENABLE_PROFILE): brief halt/read dpc/resume.
+bool riscv_sample_pc(uint32_t *out);
+
+// mcycle, read while halted (PROBE_ENABLE_REGION_TIMING).
+bool riscv_cycle_count(uint32_t *out);
+
+// Semihosting (PROBE_ENABLE_SEMIHOSTING): halted on the slli/ebreak/srai trap?
+// op = a0, arg = a1. Return sets a0 and moves dpc past the ebreak.
+bool riscv_semihost_pending(uint32_t *out_op, uint32_t *out_arg);
+bool riscv_semihost_return(uint32_t result);
@@ -1,8 +1,32 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void rsp_init(void);
 void rsp_process_byte(uint8_t c);
 void rsp_poll(void);
 
+
+// Print text on the GDB console (`O` packet). Only valid while GDB waits for a
+// reply, e.g. during a `monitor` command.
+void rsp_console_write(const char *s);
+// Same for raw bytes (target output). Also valid while the target runs under `c`.
+void rsp_console_write_bytes(const uint8_t *buf, uint32_t len);
+
+// Line buffer for target console output (semihosting, SWO): text is sent one line per
+// `O` packet, a full buffer or a partial line idle for RSP_CON_IDLE_US goes out as is.
+// Each source keeps its own, so lines from different sources don't interleave.
+#define RSP_CON_SIZE    64u
+#define RSP_CON_IDLE_US 20000u
+
+typedef struct {
+    uint8_t  buf[RSP_CON_SIZE];
+    uint32_t len;
+    uint32_t last_us;  // time of the last byte
+} rsp_console_line_t;
+
+void rsp_console_putc(rsp_console_line_t *con, uint8_t c);
+void rsp_console_flush(rsp_console_line_t *con);
+// Flush a partial line once it has been idle long enough (or now, if force).
+void rsp_console_poll(rsp_console_line_t *con, bool force);
@@ -0,0 +1,31 @@
+#pragma once
+
+// SEGGER-RTT-compatible target channel (PROBE_ENABLE_RTT). The probe finds the RTT
+// control block in target RAM (by address or by scanning for its "SEGGER RTT" ID),
+// then rsp_poll calls rtt_poll() while the target runs: new data in the up-buffers
+// is read in blocks and forwarded to GDB as `O` console packets, and RdOff is advanced.
+// The poll period adapts to the fill level, from every rsp_poll when a buffer is half
+// full up to RTT_PERIOD_MAX_US when the target is quiet.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t addr;  // control block, 0 if not attached
+    uint32_t num_up;
+    uint32_t num_down;
+    uint32_t bytes_up;    // forwarded to GDB
+    uint32_t bytes_down;  // written into down-buffer 0
+    uint32_t period_us;   // current poll period
+} rtt_stats_t;
+
+bool rtt_attach(uint32_t cb_addr);
+// Search [start, start + size) word by word; attaches on success.
+bool rtt_scan(uint32_t start, uint32_t size);
+void rtt_detach(void);
+bool rtt_attached(void);
+// force: drain now regardless of the poll period (e.g. right after a halt).
+void rtt_poll(bool force);
+// Queue host input in down-buffer 0. Returns the number of bytes the buffer took.
+uint32_t rtt_write(const uint8_t *data, uint32_t len);
+void rtt_get(rtt_stats_t *out);
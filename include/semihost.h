@@ -0,0 +1,26 @@
+#pragma once
+
+// Semihosting on the probe (PROBE_ENABLE_SEMIHOSTING). rsp_poll calls
+// semihost_on_halt() on every halt. Console output (SYS_WRITEC, SYS_WRITE0, SYS_WRITE
+// to handles 1/2) is coalesced in a line buffer and sent as `O` packets; the target is
+// resumed without a GDB round trip. File operations become GDB File-I/O `F` requests
+// (semihost_request()), answered by GDB's `F` reply (semihost_on_reply()).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    SEMIHOST_NOT_MINE = 0,  // not a semihosting halt
+    SEMIHOST_RESUME,        // handled; resume the target
+    SEMIHOST_FILEIO,        // send semihost_request() and wait for the F reply
+    SEMIHOST_EXIT,          // SYS_EXIT: report exit with semihost_exit_code()
+    SEMIHOST_ERROR,         // target access failed; report a plain stop
+} semihost_status_t;
+
+semihost_status_t semihost_on_halt(void);
+// F reply: retcode, errno (0 if absent). May ask for a follow-up request (SYS_FLEN).
+semihost_status_t semihost_on_reply(int32_t ret, uint32_t err);
+const char *semihost_request(void);
+uint8_t semihost_exit_code(void);
+// Flush console text the target left without a newline once it has sat for a while.
+void semihost_poll(void);
@@ -0,0 +1,38 @@
+#pragma once
+
+// SWO trace capture (PROBE_ENABLE_SWO, C1105 probes, v7-M/v8-M targets). The probe
+// sets up the target's TPIU for UART (NRZ) output and enables ITM stimulus ports and,
+// optionally, DWT exception trace; a second probe UART captures the SWO pin under
+// interrupt. rsp_poll calls swo_poll(), which decodes the ITM packet stream on the fly:
+// text written to stimulus port 0 is forwarded to GDB as `O` console packets, and
+// exception-entry packets are counted per exception number. The target never halts.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SWO_EXC_SLOTS 16u  // distinct exception numbers counted
+
+typedef struct {
+    bool     running;
+    bool     exc_trace;
+    uint32_t baud;        // actual SWO bit rate (trace clock / (prescaler + 1))
+    uint32_t prescaler;   // TPIU_ACPR
+    uint32_t port_mask;   // ITM_TER
+    uint32_t bytes;       // raw SWO bytes decoded
+    uint32_t text;        // port 0 bytes forwarded to GDB
+    uint32_t stimulus;    // bytes written to the other enabled ports
+    uint32_t overflows;   // ITM overflow packets (the target's trace FIFO filled)
+    uint32_t dropped;     // bytes the probe lost (its queue or UART FIFO filled)
+    uint32_t exc_other;   // exception entries beyond SWO_EXC_SLOTS distinct numbers
+} swo_stats_t;
+
+// trace_clk_hz is the target's TPIU clock (usually its core clock); baud is rounded
+// to the nearest rate the prescaler can divide down to.
+bool swo_start(uint32_t trace_clk_hz, uint32_t baud, uint32_t port_mask, bool exc_trace);
+void swo_stop(void);
+bool swo_running(void);
+// force: flush a partial console line now (e.g. right after a halt).
+void swo_poll(bool force);
+void swo_get(swo_stats_t *out);
+// Exception entry counts in first-seen order; false past the last used slot.
+bool swo_exc_get(uint32_t i, uint32_t *out_num, uint32_t *out_count);
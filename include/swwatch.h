@@ -0,0 +1,31 @@
+#pragma once
+
+// Probe-side software watchpoints: when a write watch can't be mapped to DWT
+// comparators or triggers, the probe single-steps the target itself and compares
+// the watched bytes after every instruction, instead of GDB doing the same over RSP.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "target.h"
+
+typedef enum {
+    SWWATCH_RUNNING = 0,  // still stepping; call swwatch_run() again
+    SWWATCH_HIT,          // watched bytes changed (or a hardware watch fired)
+    SWWATCH_BREAK,        // reached a breakpoint
+    SWWATCH_ERROR,        // step or memory access failed; target is halted
+} swwatch_status_t;
+
+// Only write watches can be emulated (reads leave no trace to compare).
+bool swwatch_insert(target_watch_t type, uint32_t addr, uint32_t len);
+// Returns false if no software watch matched (caller then tries the hardware one).
+bool swwatch_remove(target_watch_t type, uint32_t addr, uint32_t len);
+bool swwatch_active(void);
+
+// Snapshot the watched bytes and start stepping (replaces target_continue()).
+bool swwatch_start(void);
+bool swwatch_running(void);
+// Run one batch of steps. On SWWATCH_HIT, out_type/out_addr identify the watch.
+swwatch_status_t swwatch_run(target_watch_t *out_type, uint32_t *out_addr);
+// Stop stepping (Ctrl-C, detach) without reporting a stop. Safe to call when idle.
+void swwatch_stop(void);
@@ -28,6 +28,7 @@ bool target_is_halted(bool *halted);
 // For RISC-V:   regnum 0-31 = x0-x31, 32 = pc
 bool target_read_reg(uint32_t regnum, uint32_t *out);
 bool target_write_reg(uint32_t regnum, uint32_t val);
+bool target_read_pc(uint32_t *out);
 
 // GDB register block access (all GPRs + status in one call)
 // Returns number of 32-bit registers in the block.
@@ -39,12 +40,46 @@ bool target_write_gdb_regs(const uint32_t *regs, uint32_t count);
 void target_breakpoints_init(void);
 bool target_breakpoint_insert(uint32_t addr);
 bool target_breakpoint_remove(uint32_t addr);
+// True if GDB has a breakpoint (hardware or software) installed at addr.
+bool target_breakpoint_at(uint32_t addr);
+// Breakpoints the probe sets for itself (region timing). They share the hardware with
+// GDB's: a Z0/z0 at the same address only changes target_breakpoint_at(), and the
+// breakpoint comes out once neither side wants it. target_step() lifts one under the PC.
+bool target_probe_breakpoint_insert(uint32_t addr);
+bool target_probe_breakpoint_remove(uint32_t addr);
 
 // Watchpoints
 bool target_watchpoints_supported(void);
 bool target_watchpoint_insert(target_watch_t type, uint32_t addr, uint32_t len);
 bool target_watchpoint_remove(target_watch_t type, uint32_t addr, uint32_t len);
 bool target_watchpoint_hit(target_watch_t *out_type, uint32_t *out_addr);
+// After target_watchpoint_hit() returned false: true if the halt came only from
+// watchpoint matches that a probe-side filter rejected. Resume without reporting.
+bool target_watchpoint_filtered(void);
+
+// Data value conditions (`monitor watchval`). A watchpoint inserted at `addr` while a
+// condition exists only reports when the watched bytes equal `value` (truncated to the
+// watch length). GDB re-inserts watchpoints on every resume, so changes apply on the
+// next continue. All return false if disabled at build time.
+bool target_watch_value_set(uint32_t addr, uint32_t value);
+bool target_watch_value_clear(uint32_t addr);
+bool target_watch_value_lookup(uint32_t addr, uint32_t *out_value);
+bool target_watch_value_get(uint32_t idx, uint32_t *out_addr, uint32_t *out_value);
+
+// PC sampling while the target runs (PROBE_ENABLE_PROFILE). Returns false when no
+// sample was taken; may leave the target halted if it stopped on its own meanwhile.
+bool target_sample_pc(uint32_t *out);
+
+// Free-running core cycle counter, read while halted (PROBE_ENABLE_REGION_TIMING).
+// Cortex-M: DWT_CYCCNT. RISC-V: mcycle. False if unavailable.
+bool target_cycle_count(uint32_t *out);
+
+// Semihosting (PROBE_ENABLE_SEMIHOSTING). pending: true if the target halted on a
+// semihosting trap (Cortex-M `BKPT 0xAB`, RISC-V slli/ebreak/srai), with the operation
+// number and parameter register. return: put the result in r0/a0 and move the PC past
+// the trap; the caller resumes. Both return false if disabled at build time.
+bool target_semihost_pending(uint32_t *out_op, uint32_t *out_arg);
+bool target_semihost_return(uint32_t result);
 
 // Memory access
 bool target_mem_read_bytes(uint32_t addr, uint8_t *buf, uint32_t len);
@@ -15,5 +15,14 @@ bool target_mem_write_word_ap(uint8_t ap_sel, uint32_t addr, uint32_t v);
 bool target_mem_read_word(uint32_t addr, uint32_t *out);
 bool target_mem_write_word(uint32_t addr, uint32_t v);
 
+// Word-aligned block read: TAR is written once per 1KB auto-increment page and the
+// words stream from DRW. Bypasses software-breakpoint shadowing (for trace/RAM buffers).
+bool target_mem_read_block(uint32_t addr, uint32_t *out, uint32_t count);
+
 bool target_mem_read_bytes(uint32_t addr, uint8_t *buf, uint32_t len);
 bool target_mem_write_bytes(uint32_t addr, const uint8_t *buf, uint32_t len);
+
+// Raw MEM-AP byte access. target_mem_read_bytes/target_mem_write_bytes (target.c)
+// dispatch here for Cortex-M and add software-breakpoint shadowing on top.
+bool target_mem_read_bytes_impl(uint32_t addr, uint8_t *buf, uint32_t len);
+bool target_mem_write_bytes_impl(uint32_t addr, const uint8_t *buf, uint32_t len);
@@ -38,6 +38,18 @@
 #define PROBE_HFXOUT_IOMUX         (IOMUX_PINCM7)
 #endif
 
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+// SWO capture: UART1 RX only (adjust when schematic is set)
+#define PROBE_SWO_UART_INST        UART1
+#define PROBE_SWO_UART_IRQN        UART1_INT_IRQn
+#define PROBE_SWO_RX_IOMUX         (IOMUX_PINCM10)
+#define PROBE_SWO_RX_IOMUX_FUNC    IOMUX_PINCM10_PF_UART1_RX
+
+#ifndef PROBE_SWO_QUEUE_SIZE
+#define PROBE_SWO_QUEUE_SIZE 512u  // power of two
+#endif
+#endif
+
 static void systick_init_free_running(void)
 {
     SysTick->CTRL = 0;
@@ -236,6 +248,109 @@ void nreset_write(int level)
     }
 }
 
+// ---------------- SWO HAL (optional) ----------------
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+
+static uint8_t           g_swo_queue[PROBE_SWO_QUEUE_SIZE];
+static volatile uint32_t g_swo_head    = 0;  // written by the ISR
+static volatile uint32_t g_swo_tail    = 0;  // written by swo_getc
+static volatile uint32_t g_swo_dropped = 0;
+
+int swo_uart_start(uint32_t baud)
+{
+    // Slowest oversampling the UART supports; anything faster can't be sampled.
+    if (baud == 0u || baud > PROBE_CORE_CLK_HZ / 8u) {
+        return 0;
+    }
+    swo_uart_stop();
+
+    DL_UART_Main_reset(PROBE_SWO_UART_INST);
+    DL_UART_Main_enablePower(PROBE_SWO_UART_INST);
+    delay_cycles(16);
+
+    DL_GPIO_initPeripheralInputFunction(PROBE_SWO_RX_IOMUX, PROBE_SWO_RX_IOMUX_FUNC);
+
+    static const DL_UART_Main_ClockConfig swo_clk = {
+        .clockSel    = DL_UART_MAIN_CLOCK_BUSCLK,
+        .divideRatio = DL_UART_MAIN_CLOCK_DIVIDE_RATIO_1,
+    };
+
+    static const DL_UART_Main_Config swo_cfg = {
+        .mode        = DL_UART_MAIN_MODE_NORMAL,
+        .direction   = DL_UART_MAIN_DIRECTION_RX,
+        .flowControl = DL_UART_MAIN_FLOW_CONTROL_NONE,
+        .parity      = DL_UART_MAIN_PARITY_NONE,
+        .wordLength  = DL_UART_MAIN_WORD_LENGTH_8_BITS,
+        .stopBits    = DL_UART_MAIN_STOP_BITS_ONE,
+    };
+
+    DL_UART_Main_setClockConfig(PROBE_SWO_UART_INST, (DL_UART_Main_ClockConfig *) &swo_clk);
+    DL_UART_Main_init(PROBE_SWO_UART_INST, (DL_UART_Main_Config *) &swo_cfg);
+    DL_UART_Main_configBaudRate(PROBE_SWO_UART_INST, PROBE_CORE_CLK_HZ, baud);
+
+    // Interrupt at half full, and on RX timeout so the tail of a burst isn't left behind.
+    DL_UART_Main_enableFIFOs(PROBE_SWO_UART_INST);
+    DL_UART_Main_setRXFIFOThreshold(PROBE_SWO_UART_INST, DL_UART_RX_FIFO_LEVEL_1_2_FULL);
+    DL_UART_Main_setRXInterruptTimeout(PROBE_SWO_UART_INST, 8u);
+    DL_UART_Main_enableInterrupt(PROBE_SWO_UART_INST,
+        DL_UART_MAIN_INTERRUPT_RX | DL_UART_MAIN_INTERRUPT_RX_TIMEOUT_ERROR | DL_UART_MAIN_INTERRUPT_OVERRUN_ERROR);
+
+    g_swo_head    = 0;
+    g_swo_tail    = 0;
+    g_swo_dropped = 0;
+
+    NVIC_ClearPendingIRQ(PROBE_SWO_UART_IRQN);
+    NVIC_EnableIRQ(PROBE_SWO_UART_IRQN);
+    DL_UART_Main_enable(PROBE_SWO_UART_INST);
+    return 1;
+}
+
+void swo_uart_stop(void)
+{
+    NVIC_DisableIRQ(PROBE_SWO_UART_IRQN);
+    if (DL_UART_Main_isPowerEnabled(PROBE_SWO_UART_INST)) {
+        DL_UART_Main_disable(PROBE_SWO_UART_INST);
+        DL_UART_Main_disablePower(PROBE_SWO_UART_INST);
+    }
+}
+
+int swo_getc(void)
+{
+    uint32_t tail = g_swo_tail;
+    if (tail == g_swo_head) {
+        return -1;
+    }
+    uint8_t c  = g_swo_queue[tail];
+    g_swo_tail = (tail + 1u) & (PROBE_SWO_QUEUE_SIZE - 1u);
+    return (int) c;
+}
+
+uint32_t swo_uart_dropped(void) { return g_swo_dropped; }
+
+void UART1_IRQHandler(void)
+{
+    uint32_t head = g_swo_head;
+    while (!DL_UART_Main_isRXFIFOEmpty(PROBE_SWO_UART_INST)) {
+        uint8_t  c    = (uint8_t) DL_UART_Main_receiveData(PROBE_SWO_UART_INST);
+        uint32_t next = (head + 1u) & (PROBE_SWO_QUEUE_SIZE - 1u);
+        if (next == g_swo_tail) {
+            g_swo_dropped++;
+            continue;
+        }
+        g_swo_queue[head] = c;
+        head              = next;
+    }
+    g_swo_head = head;
+
+    if (DL_UART_Main_getRawInterruptStatus(PROBE_SWO_UART_INST, DL_UART_MAIN_INTERRUPT_OVERRUN_ERROR)) {
+        g_swo_dropped++;
+    }
+    DL_UART_Main_clearInterruptStatus(PROBE_SWO_UART_INST,
+        DL_UART_MAIN_INTERRUPT_RX | DL_UART_MAIN_INTERRUPT_RX_TIMEOUT_ERROR | DL_UART_MAIN_INTERRUPT_OVERRUN_ERROR);
+}
+
+#endif // PROBE_ENABLE_SWO
+
 // ---------------- JTAG HAL (optional) ----------------
 #if defined(PROBE_ENABLE_JTAG) && (PROBE_ENABLE_JTAG)
 
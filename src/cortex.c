@@ -6,6 +6,7 @@
 
 #include "adiv5.h"
 #include "hal.h"
+#include "target.h"
 #include "target_mem.h"
 
 // Timeout for register access operations (microseconds)
@@ -20,7 +21,13 @@
 #define DEMCR 0xE000EDFCu
 
 #define DEMCR_TRCENA   (1u << 24)
+#define DFSR_HALTED    (1u << 0)
+#define DFSR_BKPT      (1u << 1)
 #define DFSR_DWTTRAP   (1u << 2)
+#define DFSR_VCATCH    (1u << 3)
+#define DFSR_EXTERNAL  (1u << 4)
+#define DFSR_REASONS   (DFSR_BKPT | DFSR_DWTTRAP | DFSR_VCATCH | DFSR_EXTERNAL)
+#define DFSR_ALL       (DFSR_HALTED | DFSR_REASONS)
 
 #define DHCSR_DBGKEY     (0xA05Fu << 16)
 #define DHCSR_C_DEBUGEN  (1u << 0)
@@ -33,7 +40,16 @@
 #define FPB_CTRL  0xE0002000u
 #define FPB_COMP0 0xE0002008u
 
-#define DWT_CTRL 0xE0001000u
+#define DWT_CTRL   0xE0001000u
+#define DWT_CYCCNT 0xE0001004u
+#define DWT_CPICNT 0xE0001008u  // EXC, SLEEP, LSU, FOLD counters follow; 8-bit each
+#define DWT_PCSR   0xE000101Cu
+
+#define DWT_CTRL_CYCCNTENA   (1u << 0)
+#define DWT_CTRL_NOPRFCNT    (1u << 24)
+#define DWT_CTRL_NOCYCCNT    (1u << 25)
+#define DWT_CTRL_PERF_EVTENA (0x1Fu << 17)  // CPI/EXC/SLEEP/LSU/FOLD event counter enables
+
 #define DWT_COMP0 0xE0001020u
 #define DWT_MASK0 0xE0001024u
 #define DWT_FUNC0 0xE0001028u
@@ -45,10 +61,16 @@
 #define DWT_FUNC_V1_READ            (5u << 0)
 #define DWT_FUNC_V1_WRITE           (6u << 0)
 #define DWT_FUNC_V1_ACCESS          (7u << 0)
+#define DWT_FUNC_V1_DATAVMATCH      (1u << 8)
+#define DWT_FUNC_V1_DATAVADDR0(n)   ((uint32_t) (n) << 12)
+#define DWT_FUNC_V1_DATAVADDR1(n)   ((uint32_t) (n) << 16)
 
 #define DWT_FUNC_V2_MATCH_ACCESS    (4u << 0)
 #define DWT_FUNC_V2_MATCH_WRITE     (5u << 0)
 #define DWT_FUNC_V2_MATCH_READ      (6u << 0)
+#define DWT_FUNC_V2_MATCH_LIMIT     (7u << 0)
+#define DWT_FUNC_V2_MATCH_LINKED_VALUE (0xBu << 0)
+#define DWT_FUNC_V2_MATCH_MASK      (0xFu << 0)
 #define DWT_FUNC_V2_ACTION_DBG_EVENT (1u << 4)
 #define DWT_FUNC_V2_LEN_VALUE(len)  (((len) >> 1) << 10)
 
@@ -63,24 +85,53 @@ typedef struct {
 
 static bool     g_fpb_inited   = false;
 static uint8_t  g_fpb_num_code = 0;
+static uint8_t  g_fpb_rev      = 0;
 static fpb_slot_t g_fpb_slots[8];
 
+// FPB rev 0 (v6-M/v7-M) can only match addresses in the Code region.
+#define FPB_V1_CODE_LIMIT 0x20000000u
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+#define SW_BKPT_MAX   16u
+#define THUMB_BKPT    0xBE00u
+
+// Software breakpoint: BKPT patched over a RAM-resident instruction.
+typedef struct {
+    uint32_t addr;
+    uint16_t orig;
+    bool     used;
+} sw_bkpt_t;
+
+static sw_bkpt_t g_sw_bkpts[SW_BKPT_MAX];
+#endif
+
 static cortexm_target_t g_target = CORTEXM_TARGET_UNKNOWN;
 
 #if defined(PROBE_ENABLE_DWT_WATCHPOINTS) && (PROBE_ENABLE_DWT_WATCHPOINTS)
 #define DWT_MAX_SLOTS 4u
 
+#define DWT_NO_LINK   0xFFu
+
 typedef struct {
     uint32_t         addr;
     uint32_t         len;
+    uint32_t         sig;       // signature of watched bytes (filtered write watches)
+    uint32_t         value;     // data value condition (has_value)
     cortexm_watch_t  type;
     bool             used;
+    bool             linked;    // partner comparator of another slot (range limit or data value)
+    bool             filter;    // MASK region is wider than [addr, addr+len)
+    bool             has_value; // only report when the watched bytes equal `value`
+    bool             value_hw;  // value is matched by the DWT, not checked by the probe
+    uint8_t          link;      // partner comparator index, or DWT_NO_LINK
     uint8_t          slot;
 } dwt_slot_t;
 
 static bool      g_dwt_inited   = false;
 static bool      g_dwt_ok       = false;
+static bool      g_dwt_filtered = false;
 static uint8_t   g_dwt_num_comp = 0;
+static uint8_t   g_dwt_mask_max = 0;
 static dwt_slot_t g_dwt_slots[DWT_MAX_SLOTS];
 #endif
 
@@ -418,10 +469,17 @@ bool cortex_halt(void)
     return cortex_write_dhcsr(DHCSR_C_DEBUGEN | DHCSR_C_HALT);
 }
 
+// DFSR is sticky (write-1-to-clear). Clearing it on every resume means any reason bit
+// seen at the next halt belongs to that halt.
+static bool cortex_clear_dfsr(void)
+{
+    return target_mem_write_word(DFSR, DFSR_ALL);
+}
+
 bool cortex_continue(void)
 {
     // Debug enable, clear halt/step
-    return cortex_write_dhcsr(DHCSR_C_DEBUGEN);
+    return cortex_clear_dfsr() && cortex_write_dhcsr(DHCSR_C_DEBUGEN);
 }
 
 bool cortex_step(void)
@@ -433,7 +491,7 @@ bool cortex_step(void)
 
     // Set C_STEP to request single-step. Processor will execute one instruction
     // then halt and clear C_STEP automatically.
-    if (!cortex_write_dhcsr(DHCSR_C_DEBUGEN | DHCSR_C_STEP)) {
+    if (!cortex_clear_dfsr() || !cortex_write_dhcsr(DHCSR_C_DEBUGEN | DHCSR_C_STEP)) {
         return false;
     }
 
@@ -546,16 +604,6 @@ static bool is_power_of_two_u32(uint32_t v)
     return v && ((v & (v - 1u)) == 0u);
 }
 
-static uint8_t ilog2_u32(uint32_t v)
-{
-    uint8_t n = 0;
-    while (v > 1u) {
-        v >>= 1u;
-        n++;
-    }
-    return n;
-}
-
 static uint32_t dwt_v1_func(cortexm_watch_t type, uint32_t len)
 {
     uint32_t datavsize = 0;
@@ -614,11 +662,14 @@ static bool cortex_dwt_init(void)
 
     g_dwt_num_comp = 0;
     for (uint8_t i = 0; i < DWT_MAX_SLOTS; i++) {
-        g_dwt_slots[i].used = false;
-        g_dwt_slots[i].addr = 0;
-        g_dwt_slots[i].len  = 0;
-        g_dwt_slots[i].type = CORTEXM_WATCH_ACCESS;
-        g_dwt_slots[i].slot = i;
+        g_dwt_slots[i].used   = false;
+        g_dwt_slots[i].linked = false;
+        g_dwt_slots[i].filter = false;
+        g_dwt_slots[i].link   = DWT_NO_LINK;
+        g_dwt_slots[i].addr   = 0;
+        g_dwt_slots[i].len    = 0;
+        g_dwt_slots[i].type   = CORTEXM_WATCH_ACCESS;
+        g_dwt_slots[i].slot   = i;
     }
 
     uint32_t demcr = 0;
@@ -645,6 +696,17 @@ static bool cortex_dwt_init(void)
         (void) target_mem_write_word(dwt_func_reg(i), 0u);
     }
 
+    // v6-M/v7-M: MASK is WARL; the bits that stick give the largest maskable region.
+    // If the probe write fails, assume word-sized masks like before.
+    g_dwt_mask_max = 2u;
+    if (!cortex_target_is_v8m() && g_dwt_num_comp != 0) {
+        uint32_t mask = 0;
+        if (target_mem_write_word(dwt_mask_reg(0), 0x1Fu) && target_mem_read_word(dwt_mask_reg(0), &mask)) {
+            g_dwt_mask_max = (uint8_t) (mask & 0x1Fu);
+        }
+        (void) target_mem_write_word(dwt_mask_reg(0), 0u);
+    }
+
     g_dwt_ok = true;
     return true;
 }
@@ -663,6 +725,8 @@ void cortex_breakpoints_init(void)
         return;
     }
 
+    g_fpb_rev = (uint8_t) ((ctrl >> 28) & 0x0Fu);
+
     uint8_t num_code = (uint8_t) ((ctrl >> 4) & 0x0Fu);
     if (num_code > (uint8_t) (sizeof(g_fpb_slots) / sizeof(g_fpb_slots[0]))) {
         num_code = (uint8_t) (sizeof(g_fpb_slots) / sizeof(g_fpb_slots[0]));
@@ -691,15 +755,133 @@ void cortex_breakpoints_init(void)
 #endif
 }
 
-bool cortex_breakpoint_insert(uint32_t addr)
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+static sw_bkpt_t *sw_bkpt_find(uint32_t addr)
 {
-    if (!g_fpb_inited) {
-        cortex_breakpoints_init();
+    for (uint8_t i = 0; i < SW_BKPT_MAX; i++) {
+        if (g_sw_bkpts[i].used && g_sw_bkpts[i].addr == addr) {
+            return &g_sw_bkpts[i];
+        }
     }
-    if (g_fpb_num_code == 0) {
+    return NULL;
+}
+
+static bool sw_bkpt_insert(uint32_t addr)
+{
+    addr &= ~1u;
+    if (sw_bkpt_find(addr)) {
+        return true;
+    }
+
+    sw_bkpt_t *bp = NULL;
+    for (uint8_t i = 0; i < SW_BKPT_MAX; i++) {
+        if (!g_sw_bkpts[i].used) {
+            bp = &g_sw_bkpts[i];
+            break;
+        }
+    }
+    if (!bp) {
+        return false;
+    }
+
+    uint8_t orig[2];
+    if (!target_mem_read_bytes_impl(addr, orig, 2u)) {
+        return false;
+    }
+
+    const uint8_t bkpt[2] = {(uint8_t) (THUMB_BKPT & 0xFFu), (uint8_t) (THUMB_BKPT >> 8)};
+    if (!target_mem_write_bytes_impl(addr, bkpt, 2u)) {
+        return false;
+    }
+
+    // Flash (or any other non-writable memory) silently ignores the write.
+    // Read back so we only claim the breakpoint when the patch actually landed.
+    uint8_t check[2];
+    if (!target_mem_read_bytes_impl(addr, check, 2u) || check[0] != bkpt[0] || check[1] != bkpt[1]) {
+        (void) target_mem_write_bytes_impl(addr, orig, 2u);
         return false;
     }
 
+    bp->addr = addr;
+    bp->orig = (uint16_t) (orig[0] | ((uint16_t) orig[1] << 8));
+    bp->used = true;
+    return true;
+}
+
+static bool sw_bkpt_remove(uint32_t addr)
+{
+    sw_bkpt_t *bp = sw_bkpt_find(addr & ~1u);
+    if (!bp) {
+        return false;
+    }
+
+    const uint8_t orig[2] = {(uint8_t) (bp->orig & 0xFFu), (uint8_t) (bp->orig >> 8)};
+    if (!target_mem_write_bytes_impl(bp->addr, orig, 2u)) {
+        return false;
+    }
+    bp->used = false;
+    bp->addr = 0;
+    return true;
+}
+#endif
+
+void cortex_sw_breakpoints_mask_read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    for (uint8_t i = 0; i < SW_BKPT_MAX; i++) {
+        if (!g_sw_bkpts[i].used) {
+            continue;
+        }
+        for (uint32_t b = 0; b < 2u; b++) {
+            uint32_t a = g_sw_bkpts[i].addr + b;
+            if (a - addr < len) {
+                buf[a - addr] = (uint8_t) (g_sw_bkpts[i].orig >> (8u * b));
+            }
+        }
+    }
+#else
+    (void) addr;
+    (void) buf;
+    (void) len;
+#endif
+}
+
+void cortex_sw_breakpoints_after_write(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    for (uint8_t i = 0; i < SW_BKPT_MAX; i++) {
+        if (!g_sw_bkpts[i].used) {
+            continue;
+        }
+        bool hit = false;
+        for (uint32_t b = 0; b < 2u; b++) {
+            uint32_t a = g_sw_bkpts[i].addr + b;
+            if (a - addr < len) {
+                uint16_t mask = (uint16_t) (0xFFu << (8u * b));
+                g_sw_bkpts[i].orig = (uint16_t) ((g_sw_bkpts[i].orig & ~mask) | ((uint16_t) buf[a - addr] << (8u * b)));
+                hit = true;
+            }
+        }
+        if (hit) {
+            // The write clobbered the BKPT; the new bytes become the saved instruction.
+            const uint8_t bkpt[2] = {(uint8_t) (THUMB_BKPT & 0xFFu), (uint8_t) (THUMB_BKPT >> 8)};
+            (void) target_mem_write_bytes_impl(g_sw_bkpts[i].addr, bkpt, 2u);
+        }
+    }
+#else
+    (void) addr;
+    (void) buf;
+    (void) len;
+#endif
+}
+
+static bool fpb_can_match(uint32_t addr)
+{
+    return g_fpb_num_code != 0 && (g_fpb_rev != 0 || addr < FPB_V1_CODE_LIMIT);
+}
+
+static bool fpb_breakpoint_insert(uint32_t addr)
+{
     // Already installed?
     for (uint8_t i = 0; i < g_fpb_num_code; i++) {
         if (g_fpb_slots[i].used && g_fpb_slots[i].addr == addr) {
@@ -721,14 +903,40 @@ bool cortex_breakpoint_insert(uint32_t addr)
     return false;
 }
 
-bool cortex_breakpoint_remove(uint32_t addr)
+bool cortex_breakpoint_insert(uint32_t addr)
 {
     if (!g_fpb_inited) {
         cortex_breakpoints_init();
     }
-    if (g_fpb_num_code == 0) {
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    if (sw_bkpt_find(addr & ~1u)) {
+        return true;
+    }
+    if (fpb_can_match(addr) && fpb_breakpoint_insert(addr)) {
+        return true;
+    }
+    // FPB exhausted or can't reach this address: patch a BKPT if the code is in RAM.
+    return sw_bkpt_insert(addr);
+#else
+    if (!fpb_can_match(addr)) {
         return false;
     }
+    return fpb_breakpoint_insert(addr);
+#endif
+}
+
+bool cortex_breakpoint_remove(uint32_t addr)
+{
+    if (!g_fpb_inited) {
+        cortex_breakpoints_init();
+    }
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    if (sw_bkpt_find(addr & ~1u)) {
+        return sw_bkpt_remove(addr);
+    }
+#endif
 
     for (uint8_t i = 0; i < g_fpb_num_code; i++) {
         if (g_fpb_slots[i].used && g_fpb_slots[i].addr == addr) {
@@ -743,64 +951,316 @@ bool cortex_breakpoint_remove(uint32_t addr)
     return true;
 }
 
-bool cortex_watchpoint_insert(cortexm_watch_t type, uint32_t addr, uint32_t len)
+bool cortex_breakpoint_at(uint32_t addr)
 {
+    addr &= ~1u;
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    if (sw_bkpt_find(addr)) {
+        return true;
+    }
+#endif
+    for (uint8_t i = 0; i < g_fpb_num_code; i++) {
+        if (g_fpb_slots[i].used && (g_fpb_slots[i].addr & ~1u) == addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
 #if defined(PROBE_ENABLE_DWT_WATCHPOINTS) && (PROBE_ENABLE_DWT_WATCHPOINTS)
-    if (!cortex_dwt_init()) {
+// FNV-1a over the watched bytes; used to drop masked-region hits that didn't
+// change the requested range.
+static bool dwt_watch_signature(uint32_t addr, uint32_t len, uint32_t *out)
+{
+    uint8_t  buf[16];
+    uint32_t h = 2166136261u;
+    while (len) {
+        uint32_t n = (len > sizeof(buf)) ? (uint32_t) sizeof(buf) : len;
+        if (!target_mem_read_bytes(addr, buf, n)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            h = (h ^ buf[i]) * 16777619u;
+        }
+        addr += n;
+        len -= n;
+    }
+    *out = h;
+    return true;
+}
+
+static bool dwt_comp_free(uint8_t i) { return i < g_dwt_num_comp && !g_dwt_slots[i].used; }
+
+static void dwt_comp_clear(uint8_t i)
+{
+    (void) target_mem_write_word(dwt_func_reg(i), 0u);
+    (void) target_mem_write_word(dwt_mask_reg(i), 0u);
+    (void) target_mem_write_word(dwt_comp_reg(i), 0u);
+}
+
+static dwt_slot_t *dwt_find_watch(cortexm_watch_t type, uint32_t addr, uint32_t len)
+{
+    for (uint8_t i = 0; i < g_dwt_num_comp; i++) {
+        if (g_dwt_slots[i].used && !g_dwt_slots[i].linked && g_dwt_slots[i].addr == addr &&
+            g_dwt_slots[i].len == len && g_dwt_slots[i].type == type) {
+            return &g_dwt_slots[i];
+        }
+    }
+    return NULL;
+}
+
+// v6-M/v7-M: one comparator with MASK covering the smallest aligned power-of-two
+// region that contains [addr, addr+len).
+static bool dwt_insert_masked(uint8_t slot, cortexm_watch_t type, uint32_t addr, uint32_t len)
+{
+    uint32_t last = addr + len - 1u;
+    uint8_t  mask = 0;
+    while (mask < 31u && (addr >> mask) != (last >> mask)) {
+        mask++;
+    }
+    if (mask > g_dwt_mask_max) {
         return false;
     }
-    if (g_dwt_num_comp == 0) {
+    // A wider region is only filtered for writes (the watched bytes must change); a
+    // read/access watch would report every neighbour access, so leave it to GDB.
+    bool filter = (len != (1u << mask));
+    if (filter && type != CORTEXM_WATCH_WRITE) {
         return false;
     }
 
-    // Already installed?
-    for (uint8_t i = 0; i < g_dwt_num_comp; i++) {
-        if (g_dwt_slots[i].used && g_dwt_slots[i].addr == addr && g_dwt_slots[i].len == len &&
-            g_dwt_slots[i].type == type) {
-            return true;
-        }
+    uint32_t func = dwt_v1_func(type, len);
+    if (func == 0u) {
+        return false;
     }
 
-    uint8_t slot = 0xFFu;
-    for (uint8_t i = 0; i < g_dwt_num_comp; i++) {
-        if (!g_dwt_slots[i].used) {
-            slot = i;
-            break;
+    uint32_t comp = addr & ~((1u << mask) - 1u);
+    if (!target_mem_write_word(dwt_comp_reg(slot), comp)) {
+        return false;
+    }
+    if (!target_mem_write_word(dwt_mask_reg(slot), mask)) {
+        return false;
+    }
+    if (!target_mem_write_word(dwt_func_reg(slot), func)) {
+        (void) target_mem_write_word(dwt_func_reg(slot), 0u);
+        return false;
+    }
+
+    g_dwt_slots[slot].filter = filter;
+    return true;
+}
+
+// v8-M: single comparator for naturally aligned 1/2/4-byte watches.
+static bool dwt_insert_single_v8m(uint8_t slot, cortexm_watch_t type, uint32_t addr, uint32_t len)
+{
+    uint32_t func = dwt_v2_func(type, len);
+    if (func == 0u) {
+        return false;
+    }
+    if (!target_mem_write_word(dwt_comp_reg(slot), addr)) {
+        return false;
+    }
+    if (!target_mem_write_word(dwt_func_reg(slot), func)) {
+        (void) target_mem_write_word(dwt_func_reg(slot), 0u);
+        return false;
+    }
+
+    g_dwt_slots[slot].filter = false;
+    return true;
+}
+
+// v8-M: comparator n matches the range start, comparator n+1 is a "data address
+// limit" comparator holding the (inclusive) end. The pair acts as one watch.
+static bool dwt_insert_range_v8m(uint8_t slot, cortexm_watch_t type, uint32_t addr, uint32_t len)
+{
+    uint8_t lim = (uint8_t) (slot + 1u);
+    if (!dwt_comp_free(lim)) {
+        return false;
+    }
+
+    // FUNCTION.MATCH is WARL; a comparator without limit support won't keep 0b0111.
+    uint32_t rb = 0;
+    if (!target_mem_write_word(dwt_func_reg(lim), DWT_FUNC_V2_MATCH_LIMIT) ||
+        !target_mem_read_word(dwt_func_reg(lim), &rb) ||
+        (rb & DWT_FUNC_V2_MATCH_MASK) != DWT_FUNC_V2_MATCH_LIMIT) {
+        (void) target_mem_write_word(dwt_func_reg(lim), 0u);
+        return false;
+    }
+    (void) target_mem_write_word(dwt_func_reg(lim), 0u);
+
+    uint32_t func = dwt_v2_func(type, 1u);
+    if (func == 0u) {
+        return false;
+    }
+
+    if (!target_mem_write_word(dwt_comp_reg(slot), addr) ||
+        !target_mem_write_word(dwt_comp_reg(lim), addr + len - 1u) ||
+        !target_mem_write_word(dwt_func_reg(lim), DWT_FUNC_V2_MATCH_LIMIT) ||
+        !target_mem_write_word(dwt_func_reg(slot), func)) {
+        dwt_comp_clear(slot);
+        dwt_comp_clear(lim);
+        return false;
+    }
+
+    g_dwt_slots[slot].link   = lim;
+    g_dwt_slots[slot].filter = false;
+    g_dwt_slots[lim].used    = true;
+    g_dwt_slots[lim].linked  = true;
+    return true;
+}
+
+// Data value match for naturally aligned 1/2/4-byte watches: comparator `slot` holds
+// the address, a partner comparator holds the value, and only the combined match
+// halts the core. v7-M links the partner back via DATAVADDR0/1; v8-M requires the
+// value comparator to directly follow the address comparator. v6-M has no support.
+static bool dwt_insert_value(uint8_t slot, cortexm_watch_t type, uint32_t addr, uint32_t len, uint32_t value)
+{
+    if (g_target == CORTEXM_TARGET_M0 || g_target == CORTEXM_TARGET_M0P) {
+        return false;
+    }
+
+    // COMP must hold the value replicated across all byte lanes of the access size.
+    if (len == 1u) {
+        value &= 0xFFu;
+        value |= value << 8;
+    }
+    if (len <= 2u) {
+        value &= 0xFFFFu;
+        value |= value << 16;
+    }
+
+    uint8_t  vc = DWT_NO_LINK;
+    uint32_t rb = 0;
+    if (cortex_target_is_v8m()) {
+        // FUNCTION.MATCH is WARL; probe the linked data value encoding first.
+        uint8_t n = (uint8_t) (slot + 1u);
+        if (dwt_comp_free(n) && target_mem_write_word(dwt_func_reg(n), DWT_FUNC_V2_MATCH_LINKED_VALUE) &&
+            target_mem_read_word(dwt_func_reg(n), &rb) &&
+            (rb & DWT_FUNC_V2_MATCH_MASK) == DWT_FUNC_V2_MATCH_LINKED_VALUE) {
+            vc = n;
+        }
+        if (n < g_dwt_num_comp && !g_dwt_slots[n].used) {
+            (void) target_mem_write_word(dwt_func_reg(n), 0u);
+        }
+    } else {
+        // Not every comparator implements DATAVMATCH (only comparator 1 on M3/M4).
+        for (uint8_t n = 0; n < g_dwt_num_comp && vc == DWT_NO_LINK; n++) {
+            if (n == slot || !dwt_comp_free(n)) {
+                continue;
+            }
+            if (target_mem_write_word(dwt_func_reg(n), DWT_FUNC_V1_DATAVMATCH) &&
+                target_mem_read_word(dwt_func_reg(n), &rb) && (rb & DWT_FUNC_V1_DATAVMATCH)) {
+                vc = n;
+            }
+            (void) target_mem_write_word(dwt_func_reg(n), 0u);
         }
     }
-    if (slot == 0xFFu) {
+    if (vc == DWT_NO_LINK) {
         return false;
     }
 
-    uint32_t func = 0;
+    bool ok;
     if (cortex_target_is_v8m()) {
-        func = dwt_v2_func(type, len);
+        // The address comparator only feeds the value comparator (ACTION = trigger only).
+        uint32_t afunc = dwt_v2_func(type, len) & ~DWT_FUNC_V2_ACTION_DBG_EVENT;
+        uint32_t vfunc = DWT_FUNC_V2_ACTION_DBG_EVENT | DWT_FUNC_V2_MATCH_LINKED_VALUE | DWT_FUNC_V2_LEN_VALUE(len);
+        ok = afunc != 0u && target_mem_write_word(dwt_comp_reg(slot), addr) &&
+             target_mem_write_word(dwt_comp_reg(vc), value) && target_mem_write_word(dwt_func_reg(slot), afunc) &&
+             target_mem_write_word(dwt_func_reg(vc), vfunc);
     } else {
-        if (!is_power_of_two_u32(len)) {
+        // The linked address comparator stays disabled (FUNCTION = 0) on its own.
+        uint32_t vfunc = dwt_v1_func(type, len);
+        ok = vfunc != 0u && target_mem_write_word(dwt_comp_reg(slot), addr) &&
+             target_mem_write_word(dwt_mask_reg(slot), 0u) && target_mem_write_word(dwt_func_reg(slot), 0u) &&
+             target_mem_write_word(dwt_comp_reg(vc), value) && target_mem_write_word(dwt_mask_reg(vc), 0u) &&
+             target_mem_write_word(dwt_func_reg(vc), vfunc | DWT_FUNC_V1_DATAVMATCH | DWT_FUNC_V1_DATAVADDR0(slot) |
+                                                          DWT_FUNC_V1_DATAVADDR1(slot));
+    }
+    if (!ok) {
+        dwt_comp_clear(slot);
+        dwt_comp_clear(vc);
+        return false;
+    }
+
+    g_dwt_slots[slot].link   = vc;
+    g_dwt_slots[slot].filter = false;
+    g_dwt_slots[vc].used     = true;
+    g_dwt_slots[vc].linked   = true;
+    return true;
+}
+
+// Probe-side value check for watches the DWT could not match by value.
+static bool dwt_value_matches(const dwt_slot_t *w)
+{
+    uint8_t  buf[4];
+    uint32_t len = (w->len < sizeof(buf)) ? w->len : (uint32_t) sizeof(buf);
+    if (!target_mem_read_bytes(w->addr, buf, len)) {
+        return true;  // can't tell; report the hit rather than hide it
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        if (buf[i] != (uint8_t) (w->value >> (8u * i))) {
             return false;
         }
-        func = dwt_v1_func(type, len);
     }
-    if (func == 0u) {
+    return true;
+}
+#endif
+
+bool cortex_watchpoint_insert(cortexm_watch_t type, uint32_t addr, uint32_t len)
+{
+#if defined(PROBE_ENABLE_DWT_WATCHPOINTS) && (PROBE_ENABLE_DWT_WATCHPOINTS)
+    if (!cortex_dwt_init()) {
+        return false;
+    }
+    if (g_dwt_num_comp == 0) {
         return false;
     }
+    if (len == 0u) {
+        len = 1u;
+    }
 
-    uint32_t comp = addr;
-    if (len >= 2u && is_power_of_two_u32(len)) {
-        comp = addr & ~(len - 1u);
+    // Already installed?
+    if (dwt_find_watch(type, addr, len)) {
+        return true;
     }
 
-    if (!target_mem_write_word(dwt_comp_reg(slot), comp)) {
-        return false;
+    bool     aligned    = len <= 4u && is_power_of_two_u32(len) && (addr & (len - 1u)) == 0u;
+    bool     single_v8m = cortex_target_is_v8m() && aligned;
+    uint32_t value      = 0;
+    bool     has_value  = aligned && target_watch_value_lookup(addr, &value);
+    bool     value_hw   = false;
+
+    uint8_t slot = 0;
+    bool    ok   = false;
+    if (has_value) {
+        for (; slot < g_dwt_num_comp; slot++) {
+            if (dwt_comp_free(slot) && dwt_insert_value(slot, type, addr, len, value)) {
+                ok       = true;
+                value_hw = true;
+                break;
+            }
+        }
     }
-    if (!cortex_target_is_v8m()) {
-        uint32_t mask = ilog2_u32(len);
-        if (!target_mem_write_word(dwt_mask_reg(slot), mask)) {
-            return false;
+    if (!ok) {
+        // Plain address watch; a value condition is then checked by the probe on each hit.
+        for (slot = 0; slot < g_dwt_num_comp; slot++) {
+            if (!dwt_comp_free(slot)) {
+                continue;
+            }
+            if (!cortex_target_is_v8m()) {
+                ok = dwt_insert_masked(slot, type, addr, len);
+                break;  // any free comparator behaves the same
+            }
+            if (single_v8m) {
+                ok = dwt_insert_single_v8m(slot, type, addr, len);
+                break;
+            }
+            if (dwt_insert_range_v8m(slot, type, addr, len)) {
+                ok = true;
+                break;
+            }
         }
     }
-    if (!target_mem_write_word(dwt_func_reg(slot), func)) {
-        (void) target_mem_write_word(dwt_func_reg(slot), 0u);
+    if (!ok) {
         return false;
     }
 
@@ -809,6 +1269,13 @@ bool cortex_watchpoint_insert(cortexm_watch_t type, uint32_t addr, uint32_t len)
     g_dwt_slots[slot].len  = len;
     g_dwt_slots[slot].type = type;
     g_dwt_slots[slot].slot = slot;
+    g_dwt_slots[slot].sig  = 0;
+    g_dwt_slots[slot].value     = value;
+    g_dwt_slots[slot].has_value = has_value;
+    g_dwt_slots[slot].value_hw  = value_hw;
+    if (g_dwt_slots[slot].filter) {
+        (void) dwt_watch_signature(addr, len, &g_dwt_slots[slot].sig);
+    }
     return true;
 #else
     (void) type;
@@ -836,21 +1303,30 @@ bool cortex_watchpoint_remove(cortexm_watch_t type, uint32_t addr, uint32_t len)
     if (!g_dwt_inited) {
         return true;
     }
+    if (len == 0u) {
+        len = 1u;
+    }
 
-    for (uint8_t i = 0; i < g_dwt_num_comp; i++) {
-        if (g_dwt_slots[i].used && g_dwt_slots[i].addr == addr && g_dwt_slots[i].len == len &&
-            g_dwt_slots[i].type == type) {
-            uint8_t slot = g_dwt_slots[i].slot;
-            (void) target_mem_write_word(dwt_func_reg(slot), 0u);
-            (void) target_mem_write_word(dwt_mask_reg(slot), 0u);
-            (void) target_mem_write_word(dwt_comp_reg(slot), 0u);
-            g_dwt_slots[i].used = false;
-            g_dwt_slots[i].addr = 0;
-            g_dwt_slots[i].len  = 0;
-            return true;
-        }
+    dwt_slot_t *w = dwt_find_watch(type, addr, len);
+    if (!w) {
+        return true;
     }
 
+    uint8_t slots[2] = {w->slot, w->link};
+    for (uint8_t n = 0; n < 2u; n++) {
+        uint8_t slot = slots[n];
+        if (slot >= g_dwt_num_comp) {
+            continue;
+        }
+        dwt_comp_clear(slot);
+        g_dwt_slots[slot].used      = false;
+        g_dwt_slots[slot].linked    = false;
+        g_dwt_slots[slot].filter    = false;
+        g_dwt_slots[slot].has_value = false;
+        g_dwt_slots[slot].link      = DWT_NO_LINK;
+        g_dwt_slots[slot].addr      = 0;
+        g_dwt_slots[slot].len       = 0;
+    }
     return true;
 #else
     (void) type;
@@ -863,6 +1339,7 @@ bool cortex_watchpoint_remove(cortexm_watch_t type, uint32_t addr, uint32_t len)
 bool cortex_watchpoint_hit(cortexm_watch_t *out_type, uint32_t *out_addr)
 {
 #if defined(PROBE_ENABLE_DWT_WATCHPOINTS) && (PROBE_ENABLE_DWT_WATCHPOINTS)
+    g_dwt_filtered = false;
     if (!g_dwt_inited || g_dwt_num_comp == 0) {
         return false;
     }
@@ -875,7 +1352,8 @@ bool cortex_watchpoint_hit(cortexm_watch_t *out_type, uint32_t *out_addr)
         return false;
     }
 
-    bool found = false;
+    bool found    = false;
+    bool filtered = false;
     if (out_type) {
         *out_type = CORTEXM_WATCH_ACCESS;
     }
@@ -890,18 +1368,47 @@ bool cortex_watchpoint_hit(cortexm_watch_t *out_type, uint32_t *out_addr)
         }
         // Reading FUNC clears MATCHED bit; continue loop to clear all.
         // Report only the first matched watchpoint to GDB.
-        if ((func & DWT_FUNC_MATCHED) && g_dwt_slots[i].used && !found) {
-            if (out_type) {
-                *out_type = g_dwt_slots[i].type;
+        if (!(func & DWT_FUNC_MATCHED) || !g_dwt_slots[i].used || found) {
+            continue;
+        }
+
+        dwt_slot_t *w = &g_dwt_slots[i];
+        for (uint8_t h = 0; w->linked && h < g_dwt_num_comp; h++) {
+            if (g_dwt_slots[h].used && g_dwt_slots[h].link == i) {
+                w = &g_dwt_slots[h];
             }
-            if (out_addr) {
-                *out_addr = g_dwt_slots[i].addr;
+        }
+        if (w->linked) {
+            continue;
+        }
+
+        // A masked write watch also fires for neighbours of the requested bytes.
+        // If the watched bytes are unchanged, treat it as a false positive.
+        if (w->filter && w->type == CORTEXM_WATCH_WRITE) {
+            uint32_t sig = 0;
+            if (dwt_watch_signature(w->addr, w->len, &sig) && sig == w->sig) {
+                filtered = true;
+                continue;
             }
-            found = true;
+            w->sig = sig;
+        }
+
+        if (w->has_value && !w->value_hw && !dwt_value_matches(w)) {
+            filtered = true;
+            continue;
         }
+
+        if (out_type) {
+            *out_type = w->type;
+        }
+        if (out_addr) {
+            *out_addr = w->addr;
+        }
+        found = true;
     }
 
     (void) target_mem_write_word(DFSR, DFSR_DWTTRAP);
+    g_dwt_filtered = !found && filtered;
     return found;
 #else
     (void) out_type;
@@ -909,3 +1416,550 @@ bool cortex_watchpoint_hit(cortexm_watch_t *out_type, uint32_t *out_addr)
     return false;
 #endif
 }
+
+bool cortex_watchpoint_filtered(void)
+{
+#if defined(PROBE_ENABLE_DWT_WATCHPOINTS) && (PROBE_ENABLE_DWT_WATCHPOINTS)
+    return g_dwt_filtered;
+#else
+    return false;
+#endif
+}
+
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+static int8_t g_pcsr_ok = -1;  // -1 = not probed yet
+
+// Fallback for cores without PCSR: halt, read PC, resume. Leaves the core halted
+// (and returns false) if it stopped for its own reasons around the sample: resumes
+// clear DFSR, so a reason bit that appears across our halt is a breakpoint, watchpoint
+// or vector catch that GDB must see. Bits already set beforehand (left by a resume this
+// probe didn't make) can't be attributed and are ignored.
+static bool cortex_halt_sample_pc(uint32_t *out)
+{
+    uint32_t before = 0;
+    uint32_t dh     = 0;
+    if (!target_mem_read_word(DFSR, &before) || !cortex_read_dhcsr(&dh) || (dh & DHCSR_S_HALT)) {
+        return false;
+    }
+    if (!cortex_halt()) {
+        return false;
+    }
+    uint32_t dfsr = 0;
+    if (!target_mem_read_word(DFSR, &dfsr) || (dfsr & ~before & DFSR_REASONS)) {
+        return false;
+    }
+    bool ok = cortex_read_core_reg(15, out);
+    (void) cortex_continue();
+    return ok;
+}
+
+bool cortex_sample_pc(uint32_t *out)
+{
+    if (g_pcsr_ok < 0) {
+        // PCSR needs TRCENA; it is RAZ when not implemented (e.g. Cortex-M0+).
+        uint32_t demcr = 0;
+        uint32_t pcsr  = 0;
+        g_pcsr_ok      = 0;
+        if (target_mem_read_word(DEMCR, &demcr) && target_mem_write_word(DEMCR, demcr | DEMCR_TRCENA) &&
+            target_mem_read_word(DWT_PCSR, &pcsr) && pcsr != 0u) {
+            g_pcsr_ok = 1;
+        }
+    }
+    if (!g_pcsr_ok) {
+        return cortex_halt_sample_pc(out);
+    }
+
+    uint32_t pcsr = 0;
+    if (!target_mem_read_word(DWT_PCSR, &pcsr) || pcsr == 0xFFFFFFFFu) {
+        return false;  // halted, sleeping, or not sampleable (e.g. Secure state)
+    }
+    *out = pcsr;
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+bool cortex_cycle_count(uint32_t *out)
+{
+    // CYCCNT only exists on v7-M/v8-M mainline (DWT_CTRL.NOCYCCNT clear); it
+    // does not count while the core is halted.
+    uint32_t demcr = 0;
+    uint32_t ctrl  = 0;
+    if (g_target == CORTEXM_TARGET_M0 || g_target == CORTEXM_TARGET_M0P) {
+        return false;
+    }
+    if (!target_mem_read_word(DEMCR, &demcr)) {
+        return false;
+    }
+    if (!(demcr & DEMCR_TRCENA) && !target_mem_write_word(DEMCR, demcr | DEMCR_TRCENA)) {
+        return false;
+    }
+    if (!target_mem_read_word(DWT_CTRL, &ctrl) || (ctrl & DWT_CTRL_NOCYCCNT)) {
+        return false;
+    }
+    if (!(ctrl & DWT_CTRL_CYCCNTENA) && !target_mem_write_word(DWT_CTRL, ctrl | DWT_CTRL_CYCCNTENA)) {
+        return false;
+    }
+    return target_mem_read_word(DWT_CYCCNT, out);
+}
+#endif
+
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+bool cortex_perf_enable(bool on)
+{
+    uint32_t demcr = 0;
+    uint32_t ctrl  = 0;
+    if (g_target == CORTEXM_TARGET_M0 || g_target == CORTEXM_TARGET_M0P) {
+        return false;
+    }
+    if (!target_mem_read_word(DEMCR, &demcr) || !target_mem_write_word(DEMCR, demcr | DEMCR_TRCENA)) {
+        return false;
+    }
+    if (!target_mem_read_word(DWT_CTRL, &ctrl) || (ctrl & (DWT_CTRL_NOPRFCNT | DWT_CTRL_NOCYCCNT))) {
+        return false;
+    }
+    if (on) {
+        // Zero the 8-bit counters so the first delta starts clean.
+        for (uint32_t i = 0; i < CORTEX_PERF_NUM - 1u; i++) {
+            (void) target_mem_write_word(DWT_CPICNT + 4u * i, 0u);
+        }
+        ctrl |= DWT_CTRL_CYCCNTENA | DWT_CTRL_PERF_EVTENA;
+    } else {
+        ctrl &= ~DWT_CTRL_PERF_EVTENA;
+    }
+    return target_mem_write_word(DWT_CTRL, ctrl);
+}
+
+bool cortex_perf_read(uint32_t out[CORTEX_PERF_NUM])
+{
+    // CYCCNT then CPICNT..FOLDCNT: six consecutive words.
+    for (uint32_t i = 0; i < CORTEX_PERF_NUM; i++) {
+        if (!target_mem_read_word(DWT_CYCCNT + 4u * i, &out[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+#define ITM_TER  0xE0000E00u
+#define ITM_TCR  0xE0000E80u
+#define ITM_LAR  0xE0000FB0u
+#define TPIU_CSPSR 0xE0040004u
+#define TPIU_ACPR  0xE0040010u
+#define TPIU_SPPR  0xE00400F0u
+#define TPIU_FFCR  0xE0040304u
+
+#define CORESIGHT_UNLOCK    0xC5ACCE55u
+#define ITM_TCR_ITMENA      (1u << 0)
+#define ITM_TCR_TXENA       (1u << 3)   // forward DWT packets
+#define ITM_TCR_TRACEBUSID  (1u << 16)
+#define TPIU_SPPR_NRZ       2u
+#define TPIU_FFCR_TRIGIN    (1u << 8)   // formatter off, continuous mode cleared
+#define DWT_CTRL_EXCTRCENA  (1u << 16)
+
+bool cortex_swo_enable(uint32_t prescaler, uint32_t port_mask, bool exc_trace)
+{
+    uint32_t demcr = 0;
+    uint32_t ctrl  = 0;
+    if (g_target == CORTEXM_TARGET_M0 || g_target == CORTEXM_TARGET_M0P) {
+        return false;
+    }
+    if (!target_mem_read_word(DEMCR, &demcr) || !target_mem_write_word(DEMCR, demcr | DEMCR_TRCENA)) {
+        return false;
+    }
+    // TPIU: 1-bit port, UART (NRZ) encoding, bypass the formatter so ITM bytes go out raw.
+    if (!target_mem_write_word(TPIU_CSPSR, 1u) || !target_mem_write_word(TPIU_ACPR, prescaler) ||
+        !target_mem_write_word(TPIU_SPPR, TPIU_SPPR_NRZ) || !target_mem_write_word(TPIU_FFCR, TPIU_FFCR_TRIGIN)) {
+        return false;
+    }
+    if (!target_mem_write_word(ITM_LAR, CORESIGHT_UNLOCK) || !target_mem_write_word(ITM_TCR, 0u) ||
+        !target_mem_write_word(ITM_TER, port_mask)) {
+        return false;
+    }
+    if (!target_mem_read_word(DWT_CTRL, &ctrl)) {
+        return false;
+    }
+    ctrl = exc_trace ? (ctrl | DWT_CTRL_EXCTRCENA) : (ctrl & ~DWT_CTRL_EXCTRCENA);
+    if (!target_mem_write_word(DWT_CTRL, ctrl)) {
+        return false;
+    }
+    return target_mem_write_word(ITM_TCR, ITM_TCR_ITMENA | ITM_TCR_TRACEBUSID | (exc_trace ? ITM_TCR_TXENA : 0u));
+}
+
+bool cortex_swo_disable(void)
+{
+    uint32_t ctrl = 0;
+    if (!target_mem_write_word(ITM_TCR, 0u)) {
+        return false;
+    }
+    return target_mem_read_word(DWT_CTRL, &ctrl) && target_mem_write_word(DWT_CTRL, ctrl & ~DWT_CTRL_EXCTRCENA);
+}
+#endif
+
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+#define THUMB_BKPT_SEMIHOST 0xBEABu
+
+bool cortex_semihost_pending(uint32_t *out_op, uint32_t *out_arg)
+{
+    uint32_t dfsr = 0;
+    uint32_t pc   = 0;
+    uint32_t w    = 0;
+    // A watchpoint stops after the access, possibly with the PC already on a semihosting
+    // BKPT; only a BKPT halt with no watchpoint hit is a call.
+    if (!target_mem_read_word(DFSR, &dfsr) || !(dfsr & DFSR_BKPT) || (dfsr & DFSR_DWTTRAP)) {
+        return false;
+    }
+    if (!cortex_read_core_reg(15, &pc) || !target_mem_read_word(pc & ~3u, &w)) {
+        return false;
+    }
+    if (((pc & 2u) ? (w >> 16) : (w & 0xFFFFu)) != THUMB_BKPT_SEMIHOST) {
+        return false;
+    }
+    return cortex_read_core_reg(0, out_op) && cortex_read_core_reg(1, out_arg);
+}
+
+bool cortex_semihost_return(uint32_t result)
+{
+    uint32_t pc = 0;
+    return cortex_write_core_reg(0, result) && cortex_read_core_reg(15, &pc) && cortex_write_core_reg(15, pc + 2u);
+}
+#endif
+
+#if (defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)) || \
+    (defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH))
+#define DHCSR_C_MASKINTS (1u << 3)
+#define DEMCR_VC_HARDERR (1u << 10)
+#define XPSR_T           (1u << 24)
+#define XPSR_IPSR_MASK   0x1FFu
+
+static uint32_t g_call_regs[17];  // r0-r15, xPSR at cortex_call_begin()
+static uint32_t g_call_demcr;
+static uint32_t g_call_dfsr;
+static uint32_t g_call_ret;
+
+bool cortex_call_begin(void)
+{
+    bool halted = false;
+    if (g_target == CORTEXM_TARGET_UNKNOWN || !cortex_is_halted(&halted) || !halted) {
+        return false;
+    }
+    if (!cortex_read_gdb_regs(g_call_regs) || !target_mem_read_word(DEMCR, &g_call_demcr) ||
+        !target_mem_read_word(DFSR, &g_call_dfsr)) {
+        return false;
+    }
+    // A fault in the called code halts the core instead of entering the firmware's handler.
+    return target_mem_write_word(DEMCR, g_call_demcr | DEMCR_VC_HARDERR);
+}
+
+bool cortex_call_start(uint32_t entry, const uint32_t args[4], uint32_t sb, uint32_t sp, uint32_t ret)
+{
+    for (uint32_t i = 0; i < 4u; i++) {
+        if (!cortex_write_core_reg(i, args[i])) {
+            return false;
+        }
+    }
+    g_call_ret = ret & ~1u;
+    if (!cortex_write_core_reg(9, sb) || !cortex_write_core_reg(13, sp) || !cortex_write_core_reg(14, ret | 1u) ||
+        !cortex_write_core_reg(15, entry & ~1u) ||
+        !cortex_write_core_reg(16, (g_call_regs[16] & XPSR_IPSR_MASK) | XPSR_T)) {
+        return false;
+    }
+    // C_MASKINTS keeps the firmware's interrupt handlers out; it may only change while halted.
+    if (!cortex_write_dhcsr(DHCSR_C_DEBUGEN | DHCSR_C_HALT | DHCSR_C_MASKINTS) ||
+        !cortex_write_dhcsr(DHCSR_C_DEBUGEN | DHCSR_C_MASKINTS)) {
+        (void) cortex_halt();
+        return false;
+    }
+    return true;
+}
+
+bool cortex_call_wait(uint32_t timeout_us, uint32_t *out_r0)
+{
+    bool     halted = false;
+    uint32_t start  = hal_time_us();
+    while (!halted && (hal_time_us() - start) < timeout_us) {
+        if (!cortex_is_halted(&halted)) {
+            break;
+        }
+    }
+    (void) cortex_write_dhcsr(DHCSR_C_DEBUGEN | DHCSR_C_HALT | DHCSR_C_MASKINTS);
+    if (!cortex_halt() || !halted) {
+        return false;
+    }
+    // Anywhere but the return BKPT (e.g. the HardFault vector catch) is a failure.
+    uint32_t pc = 0;
+    if (!cortex_read_core_reg(15, &pc) || pc != g_call_ret) {
+        return false;
+    }
+    return cortex_read_core_reg(0, out_r0);
+}
+
+bool cortex_call_end(void)
+{
+    uint32_t dfsr = 0;
+    bool     ok   = cortex_write_gdb_regs(g_call_regs);
+    // Clear only the halt reasons the calls added.
+    if (target_mem_read_word(DFSR, &dfsr)) {
+        (void) target_mem_write_word(DFSR, dfsr & ~g_call_dfsr & DFSR_ALL);
+    }
+    return target_mem_write_word(DEMCR, g_call_demcr) && ok;
+}
+#endif
+
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+// Stubs are v6-M Thumb, position independent, use only r0-r7 and no stack, and end in
+// a BKPT as their last halfword. Data (tables, patterns) is loaded at the first word
+// boundary after the code.
+
+// memset: r0 = dst, r1 = byte, r2 = len. Bytes up to word alignment, then words.
+static const uint16_t g_stub_memset[] = {
+    0x23FF,  // 00: movs r3, #0xff
+    0x4019,  // 02: ands r1, r3
+    0x020B,  // 04: lsls r3, r1, #8
+    0x4319,  // 06: orrs r1, r3
+    0x040B,  // 08: lsls r3, r1, #16
+    0x4319,  // 0a: orrs r1, r3
+    0x2A00,  // 0c: cmp  r2, #0
+    0xD010,  // 0e: beq  32
+    0x0783,  // 10: lsls r3, r0, #30
+    0xD003,  // 12: beq  1c
+    0x7001,  // 14: strb r1, [r0]
+    0x3001,  // 16: adds r0, #1
+    0x3A01,  // 18: subs r2, #1
+    0xE7F7,  // 1a: b    0c
+    0x3A04,  // 1c: subs r2, #4
+    0xD302,  // 1e: blo  26
+    0x6001,  // 20: str  r1, [r0]
+    0x3004,  // 22: adds r0, #4
+    0xE7FA,  // 24: b    1c
+    0x3204,  // 26: adds r2, #4
+    0xD003,  // 28: beq  32
+    0x7001,  // 2a: strb r1, [r0]
+    0x3001,  // 2c: adds r0, #1
+    0x3A01,  // 2e: subs r2, #1
+    0xE7FA,  // 30: b    28
+    0xBE00,  // 32: bkpt #0
+};
+
+// crc32: r0 = crc, r1 = addr, r2 = len -> r0 = crc. Same nibble-table CRC as crc32.c,
+// with the table loaded as data at offset 0x28.
+static const uint16_t g_stub_crc32[] = {
+    0xA309,  // 00: adr  r3, 28
+    0x2A00,  // 02: cmp  r2, #0
+    0xD00F,  // 04: beq  26
+    0x780C,  // 06: ldrb r4, [r1]
+    0x3101,  // 08: adds r1, #1
+    0x0624,  // 0a: lsls r4, r4, #24
+    0x4060,  // 0c: eors r0, r4
+    0x0F04,  // 0e: lsrs r4, r0, #28
+    0x00A4,  // 10: lsls r4, r4, #2
+    0x591C,  // 12: ldr  r4, [r3, r4]
+    0x0100,  // 14: lsls r0, r0, #4
+    0x4060,  // 16: eors r0, r4
+    0x0F04,  // 18: lsrs r4, r0, #28
+    0x00A4,  // 1a: lsls r4, r4, #2
+    0x591C,  // 1c: ldr  r4, [r3, r4]
+    0x0100,  // 1e: lsls r0, r0, #4
+    0x4060,  // 20: eors r0, r4
+    0x3A01,  // 22: subs r2, #1
+    0xD1EF,  // 24: bne  06
+    0xBE00,  // 26: bkpt #0
+};
+
+static const uint32_t g_stub_crc32_table[16] = {
+    0x00000000u, 0x04C11DB7u, 0x09823B6Eu, 0x0D4326D9u, 0x130476DCu, 0x17C56B6Bu, 0x1A864DB2u, 0x1E475005u,
+    0x2608EDB8u, 0x22C9F00Fu, 0x2F8AD6D6u, 0x2B4BCB61u, 0x350C9B64u, 0x31CD86D3u, 0x3C8EA00Au, 0x384FBDBDu,
+};
+
+// search: r0 = addr, r1 = len, r2 = pattern, r3 = plen (1..len) -> r0 = match, r1 = found.
+static const uint16_t g_stub_search[] = {
+    0x1AC9,  // 00: subs r1, r1, r3
+    0x3101,  // 02: adds r1, #1
+    0x7814,  // 04: ldrb r4, [r2]
+    0x7805,  // 06: ldrb r5, [r0]
+    0x42A5,  // 08: cmp  r5, r4
+    0xD108,  // 0a: bne  1e
+    0x2601,  // 0c: movs r6, #1
+    0x429E,  // 0e: cmp  r6, r3
+    0xD009,  // 10: beq  26
+    0x5D85,  // 12: ldrb r5, [r0, r6]
+    0x5D97,  // 14: ldrb r7, [r2, r6]
+    0x42BD,  // 16: cmp  r5, r7
+    0xD101,  // 18: bne  1e
+    0x3601,  // 1a: adds r6, #1
+    0xE7F7,  // 1c: b    0e
+    0x3001,  // 1e: adds r0, #1
+    0x3901,  // 20: subs r1, #1
+    0xD1F0,  // 22: bne  06
+    0xE000,  // 24: b    28
+    0x2101,  // 26: movs r1, #1
+    0xBE00,  // 28: bkpt #0
+};
+
+static uint32_t g_stub_ram;
+static uint32_t g_stub_size;
+static uint32_t g_stub_used;      // window bytes the loaded stub clobbered
+static uint32_t g_stub_code_len;
+static bool     g_stub_fault;     // the last stub call faulted on the target
+static uint8_t  g_stub_save[CORTEX_STUB_RAM_MAX];
+
+static uint32_t stub_data_off(uint32_t code_len) { return (code_len + 3u) & ~3u; }
+
+// ~100 ms plus 8 us per byte: enough for the byte loops on cores down to a few MHz.
+static uint32_t stub_timeout_us(uint32_t len)
+{
+    return (len >= 0x1FFF0000u) ? 0xFFFFFFFFu : 100000u + (len << 3);
+}
+
+bool cortex_stub_set_ram(uint32_t addr, uint32_t size)
+{
+    if ((addr & 3u) != 0u) {
+        return false;
+    }
+    g_stub_ram  = addr;
+    g_stub_size = (size > CORTEX_STUB_RAM_MAX) ? CORTEX_STUB_RAM_MAX : size;
+    return true;
+}
+
+bool cortex_stub_get_ram(uint32_t *out_addr, uint32_t *out_size)
+{
+    *out_addr = g_stub_ram;
+    *out_size = g_stub_size;
+    return g_stub_size != 0u;
+}
+
+// Probe one byte over SWD, where a bad address fails cleanly instead of faulting the
+// core. For writes, flip it, read it back and restore it.
+static bool stub_probe(uint32_t addr, bool write)
+{
+    uint8_t b = 0;
+    uint8_t c = 0;
+    if (!target_mem_read_bytes_impl(addr, &b, 1u)) {
+        return false;
+    }
+    if (!write) {
+        return true;
+    }
+    uint8_t inv = (uint8_t) (b ^ 0xFFu);
+    c           = inv;
+    bool ok     = target_mem_write_bytes_impl(addr, &c, 1u) && target_mem_read_bytes_impl(addr, &c, 1u) && c == inv;
+    return target_mem_write_bytes_impl(addr, &b, 1u) && ok;
+}
+
+// A stub must not work on its own window, and a bad address would fault the core
+// (caught by VC_HARDERR, but it leaves the HardFault active). Probe both ends and every
+// 1 KB boundary in between, so a range running into a hole or (for memset) into flash
+// or ROM is left to the SWD path.
+static bool stub_range_ok(uint32_t addr, uint32_t len, bool write)
+{
+    uint32_t last = addr + len - 1u;
+    if (g_target == CORTEXM_TARGET_UNKNOWN || g_stub_size == 0u || len == 0u || last < addr ||
+        (addr - g_stub_ram) < g_stub_size || (g_stub_ram - addr) < len) {
+        return false;
+    }
+    uint32_t a = addr;
+    while (true) {
+        if (!stub_probe(a, write)) {
+            return false;
+        }
+        if ((a | 0x3FFu) >= last) {
+            break;
+        }
+        a = (a | 0x3FFu) + 1u;
+    }
+    return a == last || stub_probe(last, write);
+}
+
+static bool stub_unload(void)
+{
+    bool ok = target_mem_write_bytes_impl(g_stub_ram, g_stub_save, g_stub_used);
+    return cortex_call_end() && ok;
+}
+
+// Save what the stub clobbers, then copy it (and its data) into the window.
+static bool stub_load(const uint16_t *code, uint32_t code_len, const void *data, uint32_t data_len)
+{
+    uint32_t doff = stub_data_off(code_len);
+    if (doff + data_len > g_stub_size || !cortex_call_begin()) {
+        return false;
+    }
+    g_stub_used     = doff + data_len;
+    g_stub_code_len = code_len;
+    if (!target_mem_read_bytes_impl(g_stub_ram, g_stub_save, g_stub_used)) {
+        (void) cortex_call_end();
+        return false;
+    }
+    if (!target_mem_write_bytes_impl(g_stub_ram, (const uint8_t *) code, code_len) ||
+        (data_len != 0u && !target_mem_write_bytes_impl(g_stub_ram + doff, (const uint8_t *) data, data_len))) {
+        (void) stub_unload();
+        return false;
+    }
+    return true;
+}
+
+// Run the loaded stub from its start with r0-r3 = args; out = r0, r1 at its BKPT.
+static bool stub_run(const uint32_t args[4], uint32_t timeout_us, uint32_t out[2])
+{
+    uint32_t dfsr = 0;
+    if (cortex_call_start(g_stub_ram, args, g_call_regs[9], g_call_regs[13], g_stub_ram + g_stub_code_len - 2u) &&
+        cortex_call_wait(timeout_us, &out[0]) && cortex_read_core_reg(1, &out[1])) {
+        return true;
+    }
+    // A new vector catch means the stub faulted: restoring the registers doesn't undo the
+    // active HardFault, so the caller must not carry on as if nothing happened.
+    g_stub_fault = target_mem_read_word(DFSR, &dfsr) && (dfsr & ~g_call_dfsr & DFSR_VCATCH) != 0u;
+    return false;
+}
+
+bool cortex_stub_faulted(void) { return g_stub_fault; }
+
+bool cortex_stub_memset(uint32_t addr, uint8_t value, uint32_t len)
+{
+    uint32_t args[4] = {addr, value, len, 0u};
+    uint32_t out[2]  = {0};
+    g_stub_fault     = false;
+    if (!stub_range_ok(addr, len, true) || !stub_load(g_stub_memset, sizeof(g_stub_memset), NULL, 0u)) {
+        return false;
+    }
+    bool ok = stub_run(args, stub_timeout_us(len), out);
+    return stub_unload() && ok;
+}
+
+bool cortex_stub_crc32(uint32_t addr, uint32_t len, uint32_t *io_crc)
+{
+    uint32_t args[4] = {*io_crc, addr, len, 0u};
+    uint32_t out[2]  = {0};
+    g_stub_fault     = false;
+    if (!stub_range_ok(addr, len, false) ||
+        !stub_load(g_stub_crc32, sizeof(g_stub_crc32), g_stub_crc32_table, sizeof(g_stub_crc32_table))) {
+        return false;
+    }
+    bool ok = stub_run(args, stub_timeout_us(len), out);
+    if (!stub_unload() || !ok) {
+        return false;
+    }
+    *io_crc = out[0];
+    return true;
+}
+
+bool cortex_stub_search(uint32_t addr, uint32_t len, const uint8_t *pat, uint32_t plen, bool *out_found,
+                        uint32_t *out_addr)
+{
+    uint32_t args[4] = {addr, len, g_stub_ram + stub_data_off(sizeof(g_stub_search)), plen};
+    uint32_t out[2]  = {0};
+    g_stub_fault     = false;
+    if (plen == 0u || plen > len || !stub_range_ok(addr, len, false) ||
+        !stub_load(g_stub_search, sizeof(g_stub_search), pat, plen)) {
+        return false;
+    }
+    bool ok = stub_run(args, stub_timeout_us(len), out);
+    if (!stub_unload() || !ok) {
+        return false;
+    }
+    *out_found = out[1] != 0u;
+    *out_addr  = out[0];
+    return true;
+}
+#endif
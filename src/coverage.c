@@ -0,0 +1,131 @@
+// On-probe code coverage from the MTB (see coverage.h).
+
+#include "coverage.h"
+
+#include "mtb.h"
+#include "target.h"
+
+#define COVERAGE_BITS    (COVERAGE_BITMAP_BYTES * 8u)
+#define COVERAGE_MAX_RUN 0x10000u  // a longer straight-line run means a bogus packet pair
+
+static uint8_t          g_bitmap[COVERAGE_BITMAP_BYTES];
+static coverage_stats_t g_cov;
+static bool             g_active   = false;
+static bool             g_have_dst = false;
+static uint32_t         g_last_dst = 0;
+
+static void coverage_mark(uint32_t begin, uint32_t end)
+{
+    if (end < begin || end - begin >= COVERAGE_MAX_RUN) {
+        g_cov.dropped++;
+        return;
+    }
+    uint32_t last = g_cov.base + g_cov.size - 1u;
+    if (end < g_cov.base || begin > last) {
+        return;
+    }
+    if (begin < g_cov.base) {
+        begin = g_cov.base;
+    }
+    if (end > last) {
+        end = last;
+    }
+    for (uint32_t b = (begin - g_cov.base) >> g_cov.shift; b <= ((end - g_cov.base) >> g_cov.shift); b++) {
+        uint8_t bit = (uint8_t) (1u << (b & 7u));
+        if (!(g_bitmap[b >> 3] & bit)) {
+            g_bitmap[b >> 3] |= bit;
+            g_cov.covered++;
+        }
+    }
+}
+
+static void coverage_packet(uint32_t src, uint32_t dst, bool gap)
+{
+    if (gap) {
+        g_cov.overflows++;
+    }
+    // dst bit 0 (S) marks a trace restart: the run leading up to src wasn't recorded.
+    // src bit 0 (A) marks exception entry: src is the interrupted, not yet executed,
+    // instruction, so the run ends just before it (and may be empty).
+    if (g_have_dst && !gap && !(dst & 1u)) {
+        if (!(src & 1u)) {
+            coverage_mark(g_last_dst, src + 1u);
+        } else if ((src & ~1u) != g_last_dst) {
+            coverage_mark(g_last_dst, (src & ~1u) - 1u);
+        }
+    }
+    g_last_dst = dst & ~1u;
+    g_have_dst = true;
+    g_cov.packets++;
+}
+
+bool coverage_start(uint32_t base, uint32_t size, uint32_t shift)
+{
+    if (size == 0u || base + (size - 1u) < base) {
+        return false;
+    }
+    if (shift == 0u) {
+        while (((size - 1u) >> shift) >= COVERAGE_BITS) {
+            shift++;
+        }
+    }
+    if (shift > 16u || ((size - 1u) >> shift) >= COVERAGE_BITS) {
+        return false;
+    }
+    for (uint32_t i = 0; i < COVERAGE_BITMAP_BYTES; i++) {
+        g_bitmap[i] = 0;
+    }
+    g_cov.base      = base;
+    g_cov.size      = size;
+    g_cov.shift     = shift;
+    g_cov.granules  = ((size - 1u) >> shift) + 1u;
+    g_cov.covered   = 0;
+    g_cov.drains    = 0;
+    g_cov.packets   = 0;
+    g_cov.overflows = 0;
+    g_cov.dropped   = 0;
+    g_have_dst      = false;
+    g_active        = mtb_enable_autohalt();
+    return g_active;
+}
+
+void coverage_stop(void)
+{
+    if (g_active) {
+        g_active = false;
+        mtb_disable();
+    }
+}
+
+bool coverage_active(void) { return g_active && mtb_enabled(); }
+
+bool coverage_on_halt(void)
+{
+    bool watermark = false;
+    if (!mtb_drain(coverage_packet, &watermark)) {
+        return false;
+    }
+    g_cov.drains++;
+    return watermark && target_continue();
+}
+
+void coverage_get(coverage_stats_t *out) { *out = g_cov; }
+
+bool coverage_next_range(uint32_t *cursor, uint32_t *out_begin, uint32_t *out_end)
+{
+    uint32_t b = *cursor;
+    while (b < g_cov.granules && !(g_bitmap[b >> 3] & (1u << (b & 7u)))) {
+        b++;
+    }
+    if (b >= g_cov.granules) {
+        return false;
+    }
+    uint32_t e = b;
+    while (e + 1u < g_cov.granules && (g_bitmap[(e + 1u) >> 3] & (1u << ((e + 1u) & 7u)))) {
+        e++;
+    }
+    *out_begin = g_cov.base + (b << g_cov.shift);
+    *out_end   = g_cov.base + (e << g_cov.shift) + ((1u << g_cov.shift) - 1u);
+    *cursor    = e + 1u;
+    return true;
+}
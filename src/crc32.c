@@ -0,0 +1,19 @@
+// GDB CRC-32 (see crc32.h), nibble-table variant: 64 bytes of flash and no RAM, and
+// still far faster than the SWD reads that feed it.
+
+#include "crc32.h"
+
+static const uint32_t g_crc32_nibble[16] = {
+    0x00000000u, 0x04C11DB7u, 0x09823B6Eu, 0x0D4326D9u, 0x130476DCu, 0x17C56B6Bu, 0x1A864DB2u, 0x1E475005u,
+    0x2608EDB8u, 0x22C9F00Fu, 0x2F8AD6D6u, 0x2B4BCB61u, 0x350C9B64u, 0x31CD86D3u, 0x3C8EA00Au, 0x384FBDBDu,
+};
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    while (len--) {
+        crc ^= (uint32_t) *buf++ << 24;
+        crc = (crc << 4) ^ g_crc32_nibble[crc >> 28];
+        crc = (crc << 4) ^ g_crc32_nibble[crc >> 28];
+    }
+    return crc;
+}
@@ -0,0 +1,81 @@
+// Delta reads against per-block CRC signatures (see delta.h).
+
+#include "delta.h"
+
+#include "crc32.h"
+#include "target.h"
+
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+    uint16_t first;  // index of the region's first signature
+    uint16_t blocks;
+} delta_region_t;
+
+static delta_region_t g_regions[DELTA_MAX_REGIONS];
+static uint32_t       g_num_regions = 0;
+static uint32_t       g_used        = 0;  // signatures handed out
+static uint32_t       g_crc[DELTA_MAX_BLOCKS];
+static uint32_t       g_valid[DELTA_MAX_BLOCKS / 32u];  // g_crc[i] holds a sent block
+static uint32_t       g_pending = 0;                    // CRC of the block delta_next() returned
+
+bool delta_add(uint32_t addr, uint32_t len, uint32_t *out_id)
+{
+    uint32_t blocks = (len + DELTA_BLOCK - 1u) / DELTA_BLOCK;
+    if (len == 0u || addr + len < addr || g_num_regions == DELTA_MAX_REGIONS ||
+        blocks > DELTA_MAX_BLOCKS - g_used) {
+        return false;
+    }
+    delta_region_t *r = &g_regions[g_num_regions];
+    r->addr           = addr;
+    r->len            = len;
+    r->first          = (uint16_t) g_used;
+    r->blocks         = (uint16_t) blocks;
+    for (uint32_t i = g_used; i < g_used + blocks; i++) {
+        g_valid[i / 32u] &= ~(1u << (i % 32u));
+    }
+    g_used += blocks;
+    *out_id = g_num_regions++;
+    return true;
+}
+
+void delta_clear(void)
+{
+    g_num_regions = 0;
+    g_used        = 0;
+}
+
+int delta_next(uint32_t id, uint32_t *io_block, uint8_t *data, uint32_t *out_len)
+{
+    if (id >= g_num_regions) {
+        return -1;
+    }
+    const delta_region_t *r = &g_regions[id];
+    for (uint32_t b = *io_block; b < r->blocks; b++) {
+        uint32_t off = b * DELTA_BLOCK;
+        uint32_t n   = r->len - off;
+        if (n > DELTA_BLOCK) {
+            n = DELTA_BLOCK;
+        }
+        if (!target_mem_read_bytes(r->addr + off, data, n)) {
+            return -1;
+        }
+        uint32_t i   = r->first + b;
+        uint32_t crc = crc32_update(CRC32_INIT, data, n);
+        if ((g_valid[i / 32u] & (1u << (i % 32u))) && g_crc[i] == crc) {
+            continue;
+        }
+        g_pending = crc;
+        *io_block = b;
+        *out_len  = n;
+        return 1;
+    }
+    return 0;
+}
+
+void delta_commit(uint32_t id, uint32_t block)
+{
+    uint32_t i = g_regions[id].first + block;
+    g_crc[i]   = g_pending;
+    g_valid[i / 32u] |= 1u << (i % 32u);
+}
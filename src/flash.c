@@ -0,0 +1,335 @@
+// Flash programming through a RAM-resident algorithm (see flash.h).
+
+#include "flash.h"
+
+#include <string.h>
+
+#include "cortex.h"
+#include "target.h"
+
+#define FLASH_FN_ERASE   1u  // FLM Init()/UnInit() function codes
+#define FLASH_FN_PROGRAM 2u
+
+#define FLASH_INIT_TIMEOUT_US  1000000u
+#define FLASH_ERASE_TIMEOUT_US 5000000u  // per sector
+#define FLASH_PROG_TIMEOUT_US  1000000u  // per page
+
+#define FLASH_BUF_OFF   8u    // the return BKPT sits below the page buffers
+#define FLASH_STACK_MIN 256u
+#define FLASH_ERASED    0xFFu
+#define FLASH_NO_PAGE   0xFFFFFFFFu
+
+static flash_config_t g_cfg;
+static uint32_t       g_fn   = 0;              // Init() function in effect, 0 outside a session
+static uint32_t       g_page = FLASH_NO_PAGE;  // page being filled
+static uint32_t       g_lo   = 0;              // extent of the data written into it
+static uint32_t       g_hi   = 0;
+static uint32_t       g_buf  = 0;              // buffer being filled; the other may be programming
+static bool           g_busy = false;          // ProgramPage() running on the other buffer
+
+static bool is_power_of_two(uint32_t v) { return v != 0u && (v & (v - 1u)) == 0u; }
+
+static uint32_t flash_buf_addr(uint32_t i) { return g_cfg.ram + FLASH_BUF_OFF + i * g_cfg.page; }
+
+static uint32_t flash_stack_top(void) { return (g_cfg.ram + g_cfg.ram_size) & ~7u; }
+
+static bool flash_in_region(uint32_t addr, uint32_t len)
+{
+    return (addr - g_cfg.start) < g_cfg.size && len <= g_cfg.size - (addr - g_cfg.start);
+}
+
+uint32_t flash_ram_needed(uint32_t page) { return FLASH_BUF_OFF + 2u * page + FLASH_STACK_MIN; }
+
+bool flash_set_region(uint32_t start, uint32_t size, uint32_t sector, uint32_t page)
+{
+    if (g_fn != 0u || !is_power_of_two(sector) || !is_power_of_two(page) || page > sector || size == 0u ||
+        ((start | size) & (sector - 1u)) != 0u) {
+        return false;
+    }
+    g_cfg.start  = start;
+    g_cfg.size   = size;
+    g_cfg.sector = sector;
+    g_cfg.page   = page;
+    return true;
+}
+
+bool flash_set_algo(uint32_t init, uint32_t uninit, uint32_t erase, uint32_t program, uint32_t sb)
+{
+    if (g_fn != 0u) {
+        return false;
+    }
+    g_cfg.init    = init;
+    g_cfg.uninit  = uninit;
+    g_cfg.erase   = erase;
+    g_cfg.program = program;
+    g_cfg.sb      = sb;
+    return true;
+}
+
+bool flash_set_ram(uint32_t addr, uint32_t size)
+{
+    if (g_fn != 0u || (addr & 3u) != 0u) {
+        return false;
+    }
+    g_cfg.ram      = addr;
+    g_cfg.ram_size = size;
+    return true;
+}
+
+bool flash_get_config(flash_config_t *out)
+{
+    *out = g_cfg;
+    return g_cfg.size != 0u && g_cfg.program != 0u && g_cfg.ram_size >= flash_ram_needed(g_cfg.page);
+}
+
+// Call an algorithm function and wait for it; FLM functions return 0 on success.
+static bool flash_call(uint32_t entry, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t timeout_us)
+{
+    uint32_t args[4] = {a0, a1, a2, 0u};
+    uint32_t r0      = 1u;
+    return cortex_call_start(entry, args, g_cfg.sb, flash_stack_top(), g_cfg.ram) &&
+           cortex_call_wait(timeout_us, &r0) && r0 == 0u;
+}
+
+// Collect the ProgramPage() running on the other buffer, if any.
+static bool flash_wait(void)
+{
+    uint32_t r0 = 1u;
+    if (!g_busy) {
+        return true;
+    }
+    g_busy = false;
+    return cortex_call_wait(FLASH_PROG_TIMEOUT_US, &r0) && r0 == 0u;
+}
+
+// Fill [from, to) of the current buffer with the erased value.
+static bool flash_pad(uint32_t from, uint32_t to)
+{
+    uint8_t pad[32];
+    memset(pad, FLASH_ERASED, sizeof(pad));
+    while (from < to) {
+        uint32_t n = (to - from > sizeof(pad)) ? (uint32_t) sizeof(pad) : to - from;
+        if (!target_mem_write_bytes(flash_buf_addr(g_buf) + from, pad, n)) {
+            return false;
+        }
+        from += n;
+    }
+    return true;
+}
+
+// Start programming the page in the current buffer and switch to the other one. Returns
+// without waiting, so the next packets are staged while the target programs.
+static bool flash_flush(void)
+{
+    if (g_page == FLASH_NO_PAGE) {
+        return true;
+    }
+    if (!flash_pad(0u, g_lo) || !flash_pad(g_hi, g_cfg.page) || !flash_wait()) {
+        return false;
+    }
+    uint32_t args[4] = {g_page, g_cfg.page, flash_buf_addr(g_buf), 0u};
+    if (!cortex_call_start(g_cfg.program, args, g_cfg.sb, flash_stack_top(), g_cfg.ram)) {
+        return false;
+    }
+    g_busy = true;
+    g_buf ^= 1u;
+    g_page = FLASH_NO_PAGE;
+    return true;
+}
+
+void flash_abort(void)
+{
+    uint32_t r0 = 0;
+    if (g_fn == 0u) {
+        return;
+    }
+    if (g_busy) {
+        (void) cortex_call_wait(0u, &r0);  // halts the algorithm
+    }
+    (void) cortex_call_end();
+    g_fn   = 0u;
+    g_busy = false;
+    g_page = FLASH_NO_PAGE;
+}
+
+// Open a session (or switch Init() function): erase and program phases get their own
+// Init()/UnInit() pair, as the FLM convention expects.
+static bool flash_session(uint32_t fn)
+{
+    static const uint8_t k_bkpt[2] = {0x00u, 0xBEu};  // BKPT #0, where the algorithm returns
+    flash_config_t       cfg;
+
+    if (g_fn == fn) {
+        return true;
+    }
+    if (g_fn == 0u) {
+        if (!flash_get_config(&cfg) || !cortex_call_begin()) {
+            return false;
+        }
+        g_fn   = fn;
+        g_page = FLASH_NO_PAGE;
+        g_buf  = 0u;
+        g_busy = false;
+        if (!target_mem_write_bytes(g_cfg.ram, k_bkpt, sizeof(k_bkpt))) {
+            return false;
+        }
+    } else {
+        if (!flash_flush() || !flash_wait() || !flash_call(g_cfg.uninit, g_fn, 0u, 0u, FLASH_INIT_TIMEOUT_US)) {
+            return false;
+        }
+        g_fn = fn;
+    }
+    return flash_call(g_cfg.init, g_cfg.start, 0u, fn, FLASH_INIT_TIMEOUT_US);
+}
+
+static bool flash_erase_sectors(uint32_t addr, uint32_t len)
+{
+    uint32_t a = addr & ~(g_cfg.sector - 1u);
+    uint32_t n = (addr - a + len + g_cfg.sector - 1u) / g_cfg.sector;
+    if (!flash_session(FLASH_FN_ERASE)) {
+        return false;
+    }
+    for (; n; n--, a += g_cfg.sector) {
+        if (!flash_call(g_cfg.erase, a, 0u, 0u, FLASH_ERASE_TIMEOUT_US)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool flash_erase(uint32_t addr, uint32_t len)
+{
+    if (len == 0u) {
+        return true;
+    }
+    if (!flash_in_region(addr, len)) {
+        return false;
+    }
+    if (!flash_erase_sectors(addr, len)) {
+        flash_abort();
+        return false;
+    }
+    return true;
+}
+
+static bool flash_stage(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    if (!flash_session(FLASH_FN_PROGRAM)) {
+        return false;
+    }
+    while (len) {
+        uint32_t page = addr & ~(g_cfg.page - 1u);
+        uint32_t off  = addr - page;
+        uint32_t n    = (g_cfg.page - off < len) ? g_cfg.page - off : len;
+        if (page != g_page) {
+            if (!flash_flush()) {
+                return false;
+            }
+            g_page = page;
+            g_lo   = off;
+            g_hi   = off;
+        }
+        // Holes inside a page are programmed as erased bytes.
+        if ((off > g_hi && !flash_pad(g_hi, off)) || (off + n < g_lo && !flash_pad(off + n, g_lo))) {
+            return false;
+        }
+        if (!target_mem_write_bytes(flash_buf_addr(g_buf) + off, data, n)) {
+            return false;
+        }
+        g_lo = (off < g_lo) ? off : g_lo;
+        g_hi = (off + n > g_hi) ? off + n : g_hi;
+        addr += n;
+        data += n;
+        len -= n;
+        if (g_lo == 0u && g_hi == g_cfg.page && !flash_flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool flash_write(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    if (len == 0u) {
+        return true;
+    }
+    if (!flash_in_region(addr, len)) {
+        return false;
+    }
+    if (!flash_stage(addr, data, len)) {
+        flash_abort();
+        return false;
+    }
+    return true;
+}
+
+bool flash_done(void)
+{
+    if (g_fn == 0u) {
+        return true;
+    }
+    if (!flash_flush() || !flash_wait() || !flash_call(g_cfg.uninit, g_fn, 0u, 0u, FLASH_INIT_TIMEOUT_US)) {
+        flash_abort();
+        return false;
+    }
+    g_fn = 0u;
+    return cortex_call_end();
+}
+
+static uint32_t map_put(char *doc, uint32_t n, const char *s)
+{
+    while (*s) {
+        doc[n++] = *s++;
+    }
+    return n;
+}
+
+static uint32_t map_put_hex(char *doc, uint32_t n, uint32_t v)
+{
+    n = map_put(doc, n, "0x");
+    for (uint32_t i = 0; i < 8u; i++) {
+        doc[n++] = "0123456789abcdef"[(v >> (28u - 4u * i)) & 0xFu];
+    }
+    return n;
+}
+
+static uint32_t map_region(char *doc, uint32_t n, const char *type, uint32_t start, uint32_t len)
+{
+    n = map_put(doc, n, "<memory type=\"");
+    n = map_put(doc, n, type);
+    n = map_put(doc, n, "\" start=\"");
+    n = map_put_hex(doc, n, start);
+    n = map_put(doc, n, "\" length=\"");
+    n = map_put_hex(doc, n, len);
+    return map_put(doc, n, "\"");
+}
+
+bool flash_memory_map_read(uint32_t off, char *out, uint32_t len, uint32_t *out_len, bool *out_more)
+{
+    char           doc[320];
+    uint32_t       total = 0;
+    uint32_t       n     = 0;
+    flash_config_t cfg;
+
+    if (!flash_get_config(&cfg)) {
+        return false;
+    }
+    uint32_t end = cfg.start + cfg.size;  // 0 if the region ends at the top of the address space
+    total = map_put(doc, total, "<memory-map>\n");
+    if (cfg.start != 0u) {
+        total = map_put(doc, map_region(doc, total, "ram", 0u, cfg.start), "/>\n");
+    }
+    total = map_put(doc, map_region(doc, total, "flash", cfg.start, cfg.size), "><property name=\"blocksize\">");
+    total = map_put(doc, map_put_hex(doc, total, cfg.sector), "</property></memory>\n");
+    if (end != 0u) {
+        total = map_put(doc, map_region(doc, total, "ram", end, 0u - end), "/>\n");
+    }
+    total = map_put(doc, total, "</memory-map>\n");
+
+    while (n < len && off < total) {
+        out[n++] = doc[off++];
+    }
+    *out_len  = n;
+    *out_more = off < total;
+    return true;
+}
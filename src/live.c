@@ -0,0 +1,144 @@
+// Live watch streaming (see live.h).
+
+#include "live.h"
+
+#include "hal.h"
+#include "rsp.h"
+#include "target.h"
+
+#ifndef PROBE_UART_BAUD
+#define PROBE_UART_BAUD 115200u
+#endif
+
+// "L " + 8 hex digits, then " " + 2 hex digits per byte for each region, then "\n".
+#define LIVE_FRAME_MAX    (2u + 8u + LIVE_MAX_REGIONS + 2u * LIVE_MAX_BYTES + 1u)
+#define LIVE_PACKET_EXTRA 5u  // '$', 'O', '#', checksum; each text byte is sent as 2 hex chars
+#define LIVE_LINK_SHARE   4u  // frames may use up to 3/4 of the UART, leaving room for GDB
+
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+} live_region_t;
+
+static live_region_t g_regions[LIVE_MAX_REGIONS];
+static live_stats_t  g_live;
+static uint32_t      g_rate_req  = 0;  // as asked for; re-capped when regions change
+static uint32_t      g_period_us = 0;
+static uint32_t      g_start_us  = 0;
+static uint32_t      g_next_us   = 0;
+static char          g_frame[LIVE_FRAME_MAX];
+
+static uint32_t live_frame_len(void) { return 2u + 8u + g_live.regions + 2u * g_live.bytes + 1u; }
+
+static void live_apply_rate(void)
+{
+    uint32_t wire = 2u * live_frame_len() + LIVE_PACKET_EXTRA;
+    uint32_t max  = (PROBE_UART_BAUD / 10u) * (LIVE_LINK_SHARE - 1u) / LIVE_LINK_SHARE / wire;
+    if (max == 0u) {
+        max = 1u;
+    }
+    g_live.rate_hz = (g_rate_req > max) ? max : g_rate_req;
+    g_period_us    = 1000000u / g_live.rate_hz;
+}
+
+bool live_add(uint32_t addr, uint32_t len)
+{
+    if (len == 0u || g_live.regions == LIVE_MAX_REGIONS || len > LIVE_MAX_BYTES - g_live.bytes) {
+        return false;
+    }
+    g_regions[g_live.regions].addr = addr;
+    g_regions[g_live.regions].len  = len;
+    g_live.regions++;
+    g_live.bytes += len;
+    if (g_live.running) {
+        live_apply_rate();
+    }
+    return true;
+}
+
+void live_clear(void)
+{
+    g_live.running = false;
+    g_live.regions = 0;
+    g_live.bytes   = 0;
+}
+
+bool live_region(uint32_t i, uint32_t *out_addr, uint32_t *out_len)
+{
+    if (i >= g_live.regions) {
+        return false;
+    }
+    *out_addr = g_regions[i].addr;
+    *out_len  = g_regions[i].len;
+    return true;
+}
+
+bool live_start(uint32_t rate_hz)
+{
+    if (rate_hz == 0u || g_live.regions == 0u) {
+        return false;
+    }
+    g_rate_req = rate_hz;
+    live_apply_rate();
+    g_live.frames  = 0;
+    g_live.skipped = 0;
+    g_live.errors  = 0;
+    g_start_us     = hal_time_us();
+    g_next_us      = g_start_us;
+    g_live.running = true;
+    return true;
+}
+
+void live_stop(void) { g_live.running = false; }
+
+static uint32_t live_put_hex32(uint32_t pos, uint32_t v)
+{
+    for (uint32_t i = 0; i < 8u; i++) {
+        g_frame[pos++] = "0123456789abcdef"[(v >> (28u - 4u * i)) & 0xFu];
+    }
+    return pos;
+}
+
+void live_poll(void)
+{
+    if (!g_live.running) {
+        return;
+    }
+    uint32_t now = hal_time_us();
+    if ((int32_t) (now - g_next_us) < 0) {
+        return;
+    }
+    // Stay on the sample grid; if a whole period or more was missed, skip ahead.
+    uint32_t late = now - g_next_us;
+    if (late >= g_period_us) {
+        g_live.skipped += late / g_period_us;
+        g_next_us += (late / g_period_us) * g_period_us;
+    }
+    g_next_us += g_period_us;
+
+    uint32_t pos = 0;
+    g_frame[pos++] = 'L';
+    g_frame[pos++] = ' ';
+    pos = live_put_hex32(pos, now - g_start_us);
+    for (uint32_t r = 0; r < g_live.regions; r++) {
+        uint32_t len = g_regions[r].len;
+        g_frame[pos++] = ' ';
+        // Read into the upper half of this region's hex span, then expand in place:
+        // the write cursor (2i) never passes the read cursor (len + i).
+        uint8_t *raw = (uint8_t *) &g_frame[pos + len];
+        if (!target_mem_read_bytes(g_regions[r].addr, raw, len)) {
+            g_live.errors++;
+            return;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            uint8_t b      = raw[i];
+            g_frame[pos++] = "0123456789abcdef"[b >> 4];
+            g_frame[pos++] = "0123456789abcdef"[b & 0xFu];
+        }
+    }
+    g_frame[pos++] = '\n';
+    rsp_console_write_bytes((const uint8_t *) g_frame, pos);
+    g_live.frames++;
+}
+
+void live_get(live_stats_t *out) { *out = g_live; }
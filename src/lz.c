@@ -0,0 +1,243 @@
+// LZ77 codec for compressed memory transfers (see lz.h).
+
+#include "lz.h"
+
+#include <string.h>
+
+#include "target.h"
+
+#if defined(PROBE_ENABLE_COMPRESSED_READ) && (PROBE_ENABLE_COMPRESSED_READ)
+#define LZ_BLOCK     (LZ_WINDOW / 2u)  // bytes read from the target per step
+#define LZ_HASH_BITS 6u
+
+typedef struct {
+    uint32_t addr;     // start of the whole transfer
+    uint32_t len;
+    uint32_t done;     // input bytes compressed so far
+    uint32_t sent;     // compressed bytes consumed so far
+    uint16_t out_pos;
+    uint16_t out_len;
+    bool     error;
+} lz_read_t;
+
+// win[0, LZ_BLOCK) holds the previous block (history), win[LZ_BLOCK, LZ_WINDOW) the
+// block being compressed. The hash table keeps the low 16 bits of the stream position
+// where each 3-byte prefix was last seen; candidates are verified byte by byte.
+static lz_read_t g_rd;
+static uint8_t   g_win[LZ_WINDOW];
+static uint8_t   g_out[LZ_BLOCK + LZ_BLOCK / LZ_MAX_RUN];
+static uint16_t  g_hash[1u << LZ_HASH_BITS];
+
+static uint32_t lz_hash(const uint8_t *p)
+{
+    uint32_t v = (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16);
+    return (v * 2654435761u) >> (32u - LZ_HASH_BITS);
+}
+
+static void lz_emit_literals(const uint8_t *src, uint32_t n)
+{
+    while (n) {
+        uint32_t k = (n > LZ_MAX_RUN) ? LZ_MAX_RUN : n;
+        g_out[g_rd.out_len++] = (uint8_t) (k - 1u);
+        memcpy(&g_out[g_rd.out_len], src, k);
+        g_rd.out_len = (uint16_t) (g_rd.out_len + k);
+        src += k;
+        n -= k;
+    }
+}
+
+// Compress win[LZ_BLOCK, LZ_BLOCK + n); hist bytes before it are valid history.
+static void lz_compress_block(uint32_t n, uint32_t hist)
+{
+    uint32_t end       = LZ_BLOCK + n;
+    uint32_t lit       = LZ_BLOCK;
+    uint32_t i         = LZ_BLOCK;
+    uint32_t pos0      = g_rd.done - LZ_BLOCK;  // stream position of win[0]
+    uint32_t win_first = LZ_BLOCK - hist;
+
+    g_rd.out_pos = 0;
+    g_rd.out_len = 0;
+    while (i < end) {
+        uint32_t best = 0;
+        uint32_t dist = 0;
+        if (end - i >= LZ_MIN_MATCH) {
+            uint32_t h    = lz_hash(&g_win[i]);
+            uint32_t back = (uint16_t) ((uint16_t) (pos0 + i) - g_hash[h]);
+            g_hash[h]     = (uint16_t) (pos0 + i);
+            if (back != 0u && back <= LZ_WINDOW && back <= i - win_first) {
+                uint32_t max = end - i;
+                if (max > LZ_MAX_MATCH) {
+                    max = LZ_MAX_MATCH;
+                }
+                const uint8_t *a = &g_win[i];
+                const uint8_t *b = &g_win[i - back];
+                while (best < max && a[best] == b[best]) {
+                    best++;
+                }
+                dist = back;
+            }
+        }
+        if (best < LZ_MIN_MATCH) {
+            i++;
+            continue;
+        }
+        lz_emit_literals(&g_win[lit], i - lit);
+        g_out[g_rd.out_len++] = (uint8_t) (0x80u | (best - LZ_MIN_MATCH));
+        g_out[g_rd.out_len++] = (uint8_t) (dist - 1u);
+        for (uint32_t k = 1; k < best && i + k + LZ_MIN_MATCH <= end; k++) {
+            g_hash[lz_hash(&g_win[i + k])] = (uint16_t) (pos0 + i + k);
+        }
+        i += best;
+        lit = i;
+    }
+    lz_emit_literals(&g_win[lit], end - lit);
+}
+
+static bool lz_read_block(void)
+{
+    uint32_t n = g_rd.len - g_rd.done;
+    if (n > LZ_BLOCK) {
+        n = LZ_BLOCK;
+    }
+    uint32_t hist = (g_rd.done > LZ_BLOCK) ? LZ_BLOCK : g_rd.done;
+    // The previous block becomes history.
+    memcpy(g_win, &g_win[LZ_BLOCK], LZ_BLOCK);
+    if (!target_mem_read_bytes(g_rd.addr + g_rd.done, &g_win[LZ_BLOCK], n)) {
+        return false;
+    }
+    lz_compress_block(n, hist);
+    g_rd.done += n;
+    return true;
+}
+
+void lz_read_start(uint32_t addr, uint32_t len)
+{
+    g_rd.addr    = addr;
+    g_rd.len     = len;
+    g_rd.done    = 0;
+    g_rd.sent    = 0;
+    g_rd.out_pos = 0;
+    g_rd.out_len = 0;
+    g_rd.error   = false;
+}
+
+bool lz_read_matches(uint32_t addr, uint32_t len, uint32_t offset)
+{
+    return addr == g_rd.addr && len == g_rd.len && offset == g_rd.sent;
+}
+
+int lz_read_peek(void)
+{
+    if (g_rd.error) {
+        return -2;
+    }
+    if (g_rd.out_pos == g_rd.out_len) {
+        if (g_rd.done == g_rd.len) {
+            return -1;
+        }
+        if (!lz_read_block()) {
+            g_rd.error = true;
+            return -2;
+        }
+    }
+    return g_out[g_rd.out_pos];
+}
+
+void lz_read_skip(void)
+{
+    g_rd.out_pos++;
+    g_rd.sent++;
+}
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE)
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+    uint32_t out;       // bytes decoded
+    uint32_t written;   // bytes written to the target
+    uint32_t consumed;  // compressed bytes fed
+    uint8_t  lit;       // literal bytes still to come in the current run
+    uint8_t  match;     // length of a match waiting for its distance byte, 0 if none
+    bool     error;
+} lz_write_t;
+
+static lz_write_t g_wr;
+static uint8_t    g_ring[LZ_WINDOW];  // the last LZ_WINDOW decoded bytes, by out % LZ_WINDOW
+
+static bool lz_write_flush(void)
+{
+    while (g_wr.written != g_wr.out) {
+        uint32_t at = g_wr.written % LZ_WINDOW;
+        uint32_t n  = g_wr.out - g_wr.written;
+        if (n > LZ_WINDOW - at) {
+            n = LZ_WINDOW - at;  // up to the end of the ring, then the rest from its start
+        }
+        if (!target_mem_write_bytes(g_wr.addr + g_wr.written, &g_ring[at], n)) {
+            return false;
+        }
+        g_wr.written += n;
+    }
+    return true;
+}
+
+static bool lz_write_put(uint8_t c)
+{
+    if (g_wr.out == g_wr.len) {
+        return false;
+    }
+    g_ring[g_wr.out % LZ_WINDOW] = c;
+    g_wr.out++;
+    // Write out before undecoded history could be overwritten.
+    return (g_wr.out - g_wr.written < LZ_WINDOW / 2u) || lz_write_flush();
+}
+
+void lz_write_start(uint32_t addr, uint32_t len)
+{
+    g_wr.addr     = addr;
+    g_wr.len      = len;
+    g_wr.out      = 0;
+    g_wr.written  = 0;
+    g_wr.consumed = 0;
+    g_wr.lit      = 0;
+    g_wr.match    = 0;
+    g_wr.error    = false;
+}
+
+bool lz_write_matches(uint32_t addr, uint32_t len, uint32_t offset)
+{
+    return !g_wr.error && addr == g_wr.addr && len == g_wr.len && offset == g_wr.consumed;
+}
+
+bool lz_write_feed(const uint8_t *data, uint32_t n)
+{
+    for (uint32_t i = 0; i < n && !g_wr.error; i++) {
+        uint8_t b = data[i];
+        if (g_wr.lit) {
+            g_wr.lit--;
+            g_wr.error = !lz_write_put(b);
+        } else if (g_wr.match) {
+            uint32_t dist = (uint32_t) b + 1u;
+            if (dist > g_wr.out) {
+                g_wr.error = true;
+                break;
+            }
+            for (uint32_t k = 0; k < g_wr.match && !g_wr.error; k++) {
+                g_wr.error = !lz_write_put(g_ring[(g_wr.out - dist) % LZ_WINDOW]);
+            }
+            g_wr.match = 0;
+        } else if (b < LZ_MAX_RUN) {
+            g_wr.lit = (uint8_t) (b + 1u);
+        } else {
+            g_wr.match = (uint8_t) ((b & 0x7Fu) + LZ_MIN_MATCH);
+        }
+    }
+    g_wr.consumed += n;
+    if (!g_wr.error && !lz_write_flush()) {
+        g_wr.error = true;
+    }
+    return !g_wr.error;
+}
+
+uint32_t lz_write_done(void) { return g_wr.written; }
+#endif
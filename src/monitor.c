@@ -0,0 +1,927 @@
+// GDB `monitor` commands (qRcmd).
+// Commands print through a small line buffer that is flushed to the GDB console as
+// `O` packets; the table only contains commands for features built into the probe.
+
+#include "monitor.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rsp.h"
+#include "target.h"
+
+#if defined(PROBE_ENABLE_POLL_WATCH) && (PROBE_ENABLE_POLL_WATCH)
+#include "pollwatch.h"
+#endif
+
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+#include "profile.h"
+#endif
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+#include "regiontime.h"
+#endif
+
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+#include "perfcnt.h"
+#endif
+
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+#include "mtb.h"
+#endif
+
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+#include "coverage.h"
+#endif
+
+#if defined(PROBE_ENABLE_RTT) && (PROBE_ENABLE_RTT)
+#include "rtt.h"
+#endif
+
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+#include "swo.h"
+#endif
+
+#if defined(PROBE_ENABLE_LIVE_WATCH) && (PROBE_ENABLE_LIVE_WATCH)
+#include "live.h"
+#endif
+
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+#include "cortex.h"
+#endif
+
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+#include "flash.h"
+#endif
+
+#define MONITOR_MAX_ARGS 8u
+#define MONITOR_LINE_MAX 64u
+
+typedef bool (*monitor_fn_t)(uint32_t argc, char **argv);
+
+typedef struct {
+    const char  *name;
+    monitor_fn_t fn;
+    const char  *help;
+} monitor_cmd_t;
+
+static char     g_mon_line[MONITOR_LINE_MAX + 2u];
+static uint32_t g_mon_len = 0;
+
+static void mon_flush(void)
+{
+    g_mon_line[g_mon_len++] = '\n';
+    g_mon_line[g_mon_len]   = '\0';
+    rsp_console_write(g_mon_line);
+    g_mon_len = 0;
+}
+
+static void mon_puts(const char *s)
+{
+    while (*s) {
+        if (g_mon_len >= MONITOR_LINE_MAX) {
+            mon_flush();
+        }
+        g_mon_line[g_mon_len++] = *s++;
+    }
+}
+
+static void mon_put_hex(uint32_t v)
+{
+    char buf[11] = "0x";
+    for (uint32_t i = 0; i < 8u; i++) {
+        buf[2u + i] = "0123456789abcdef"[(v >> (28u - 4u * i)) & 0xFu];
+    }
+    buf[10] = '\0';
+    mon_puts(buf);
+}
+
+static void mon_put_dec(uint32_t v)
+{
+    char     buf[11];
+    uint32_t n = sizeof(buf) - 1u;
+    buf[n]     = '\0';
+    do {
+        buf[--n] = (char) ('0' + (v % 10u));
+        v /= 10u;
+    } while (v);
+    mon_puts(&buf[n]);
+}
+
+static void mon_println(const char *s)
+{
+    mon_puts(s);
+    mon_flush();
+}
+
+// Accepts 0x-prefixed hex or plain decimal.
+static bool mon_parse_u32(const char *s, uint32_t *out)
+{
+    uint32_t v    = 0;
+    uint32_t base = 10u;
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16u;
+        s += 2;
+    }
+    if (*s == '\0') {
+        return false;
+    }
+    for (; *s; s++) {
+        uint32_t d;
+        if (*s >= '0' && *s <= '9') {
+            d = (uint32_t) (*s - '0');
+        } else if (base == 16u && *s >= 'a' && *s <= 'f') {
+            d = (uint32_t) (*s - 'a' + 10);
+        } else if (base == 16u && *s >= 'A' && *s <= 'F') {
+            d = (uint32_t) (*s - 'A' + 10);
+        } else {
+            return false;
+        }
+        if (d >= base) {
+            return false;
+        }
+        v = v * base + d;
+    }
+    *out = v;
+    return true;
+}
+
+static bool mon_help(uint32_t argc, char **argv);
+
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+static bool mon_watchval(uint32_t argc, char **argv)
+{
+    uint32_t addr  = 0;
+    uint32_t value = 0;
+
+    if (argc == 1u) {
+        uint32_t n = 0;
+        while (target_watch_value_get(n, &addr, &value)) {
+            mon_puts("watch ");
+            mon_put_hex(addr);
+            mon_puts(" if == ");
+            mon_put_hex(value);
+            mon_flush();
+            n++;
+        }
+        if (n == 0u) {
+            mon_println("no value conditions");
+        }
+        return true;
+    }
+
+    if (strcmp(argv[1], "clear") == 0) {
+        if (argc == 3u) {
+            if (!mon_parse_u32(argv[2], &addr) || !target_watch_value_clear(addr)) {
+                mon_println("no condition at that address");
+                return false;
+            }
+            return true;
+        }
+        while (target_watch_value_get(0u, &addr, &value)) {
+            (void) target_watch_value_clear(addr);
+        }
+        return true;
+    }
+
+    if (argc != 3u || !mon_parse_u32(argv[1], &addr) || !mon_parse_u32(argv[2], &value)) {
+        mon_println("usage: watchval [<addr> <value> | clear [<addr>]]");
+        return false;
+    }
+    if (!target_watch_value_set(addr, value)) {
+        mon_println("value condition table full");
+        return false;
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_POLL_WATCH) && (PROBE_ENABLE_POLL_WATCH)
+static bool mon_pollwatch(uint32_t argc, char **argv)
+{
+    uint32_t addr   = 0;
+    uint32_t value  = 0;
+    uint32_t mask   = 0xFFFFFFFFu;
+    uint32_t period = 1000u;
+
+    if (argc == 1u) {
+        if (!pollwatch_get(&addr, &value, &mask, &period)) {
+            mon_println("pollwatch off");
+            return true;
+        }
+        mon_puts("pollwatch ");
+        mon_put_hex(addr);
+        mon_puts(" & ");
+        mon_put_hex(mask);
+        mon_puts(" == ");
+        mon_put_hex(value);
+        mon_puts(" every ");
+        mon_put_dec(period);
+        mon_println(" us");
+        return true;
+    }
+
+    if (argc == 2u && strcmp(argv[1], "clear") == 0) {
+        pollwatch_clear();
+        return true;
+    }
+
+    if (argc < 3u || !mon_parse_u32(argv[1], &addr) || !mon_parse_u32(argv[2], &value) ||
+        (argc > 3u && !mon_parse_u32(argv[3], &mask)) || (argc > 4u && !mon_parse_u32(argv[4], &period)) ||
+        !pollwatch_set(addr, value, mask, period)) {
+        mon_println("usage: pollwatch [<addr> <value> [<mask> [<period_us>]] | clear]");
+        return false;
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+static uint32_t mon_percent(uint32_t part, uint32_t total)
+{
+    if (total == 0u) {
+        return 0u;
+    }
+    return (part < 0x28F5C28u) ? (part * 100u) / total : part / (total / 100u);
+}
+
+static bool mon_profile(uint32_t argc, char **argv)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    if (argc >= 2u && strcmp(argv[1], "start") == 0) {
+        a = 1000u;
+        b = profile_shift();
+        if ((argc > 2u && !mon_parse_u32(argv[2], &a)) || (argc > 3u && !mon_parse_u32(argv[3], &b)) ||
+            !profile_start(a, b)) {
+            mon_println("usage: profile start [<period_us> [<bin_shift 0..16>]]");
+            return false;
+        }
+        return true;
+    }
+    if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        profile_stop();
+        return true;
+    }
+    if (argc == 2u && strcmp(argv[1], "clear") == 0) {
+        profile_clear();
+        return true;
+    }
+
+    uint32_t top = 10u;
+    if (argc > 2u || (argc == 2u && !mon_parse_u32(argv[1], &top))) {
+        mon_println("usage: profile [<top_n> | start [<period_us> [<bin_shift>]] | stop | clear]");
+        return false;
+    }
+
+    uint32_t samples  = 0;
+    uint32_t missed   = 0;
+    uint32_t unbinned = 0;
+    profile_totals(&samples, &missed, &unbinned);
+    mon_puts(profile_enabled() ? "profile on: " : "profile off: ");
+    mon_put_dec(samples);
+    mon_puts(" samples, ");
+    mon_put_dec(missed);
+    mon_puts(" missed, ");
+    mon_put_dec(unbinned);
+    mon_puts(" unbinned, ");
+    mon_put_dec(1u << profile_shift());
+    mon_println("-byte bins");
+
+    for (uint32_t r = 0; r < top && profile_top(r, &a, &b); r++) {
+        mon_put_hex(a);
+        mon_puts("  ");
+        mon_put_dec(b);
+        mon_puts("  ");
+        mon_put_dec(mon_percent(b, samples));
+        mon_println("%");
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+static bool mon_time(uint32_t argc, char **argv)
+{
+    if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        regiontime_stop();
+        return true;
+    }
+
+    if (argc == 1u) {
+        regiontime_stats_t st;
+        if (!regiontime_stats(&st)) {
+            mon_println("no timing run");
+            return true;
+        }
+        mon_puts("time ");
+        mon_put_hex(st.start);
+        mon_puts(" -> ");
+        mon_put_hex(st.end);
+        mon_puts(regiontime_active() ? " (running): " : ": ");
+        mon_put_dec(st.count);
+        mon_puts("/");
+        mon_put_dec(st.iterations);
+        mon_flush();
+        if (st.count != 0u) {
+            mon_puts("  cycles min ");
+            mon_put_dec(st.min);
+            mon_puts(" max ");
+            mon_put_dec(st.max);
+            mon_puts(" mean ");
+            mon_put_dec(st.mean);
+            mon_flush();
+        }
+        return true;
+    }
+
+    uint32_t start = 0;
+    uint32_t end   = 0;
+    uint32_t n     = 100u;
+    if (argc < 3u || argc > 4u || !mon_parse_u32(argv[1], &start) || !mon_parse_u32(argv[2], &end) ||
+        (argc == 4u && !mon_parse_u32(argv[3], &n))) {
+        mon_println("usage: time [<start> <end> [<iterations>] | stop]");
+        return false;
+    }
+    if (!regiontime_start(start, end, n)) {
+        mon_println("time: no cycle counter, or breakpoints unavailable");
+        return false;
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+static bool mon_perfcounters(uint32_t argc, char **argv)
+{
+    static const char *const names[PERFCNT_NUM] = {"cyc  ", "cpi  ", "exc  ", "sleep", "lsu  ", "fold "};
+
+    if (argc >= 2u && strcmp(argv[1], "start") == 0) {
+        uint32_t period = 0;
+        if (argc > 3u || (argc == 3u && !mon_parse_u32(argv[2], &period))) {
+            mon_println("usage: perfcounters start [<period_us>]");
+            return false;
+        }
+        if (!perfcnt_start(period)) {
+            mon_println("perfcounters: DWT profiling counters not implemented");
+            return false;
+        }
+        return true;
+    }
+    if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        perfcnt_stop();
+        return true;
+    }
+    if (argc != 1u) {
+        mon_println("usage: perfcounters [start [<period_us>] | stop]");
+        return false;
+    }
+
+    perfcnt_stats_t st;
+    perfcnt_get(&st);
+    uint32_t ms = st.elapsed_ms;
+    mon_puts(perfcnt_running() ? "perfcounters on: " : "perfcounters off: ");
+    mon_put_dec(ms);
+    mon_puts(" ms, ");
+    mon_put_dec(st.polls);
+    mon_println(" polls");
+    for (uint32_t i = 0; i < PERFCNT_NUM; i++) {
+        uint32_t t = st.total[i];
+        mon_puts(names[i]);
+        mon_puts(" ");
+        mon_put_dec(t);
+        mon_puts("  ");
+        mon_put_dec(ms ? (t / ms) * 1000u + ((t % ms) * 1000u) / ms : 0u);
+        // A step of more than half the 8-bit range means a wrap between polls was likely.
+        mon_println((i != 0u && st.max_delta[i] > 0x80u) ? "/s (may wrap, low)" : "/s");
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+static bool mon_mtb(uint32_t argc, char **argv)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    if (argc == 3u && strcmp(argv[1], "base") == 0) {
+        if (!mon_parse_u32(argv[2], &a)) {
+            mon_println("usage: mtb base <addr>");
+            return false;
+        }
+        mtb_set_base(a);
+        return true;
+    }
+    if (argc >= 2u && strcmp(argv[1], "window") == 0) {
+        if (argc != 4u || !mon_parse_u32(argv[2], &a) || !mon_parse_u32(argv[3], &b)) {
+            mon_println("usage: mtb window <addr> <size>");
+            return false;
+        }
+        if (!mtb_set_window(a, b)) {
+            mon_println("mtb: window must be a power of two >= 16, size-aligned in MTB SRAM");
+            return false;
+        }
+        return true;
+    }
+    if (argc == 2u && strcmp(argv[1], "on") == 0) {
+        if (!mtb_enable()) {
+            mon_println("mtb: not found or no window (see 'mtb window')");
+            return false;
+        }
+        return true;
+    }
+    if (argc == 2u && strcmp(argv[1], "off") == 0) {
+        mtb_disable();
+        return true;
+    }
+    if (argc != 1u) {
+        mon_println("usage: mtb [base <addr> | window <addr> <size> | on | off]");
+        return false;
+    }
+
+    mtb_info_t info;
+    if (!mtb_get_info(&info)) {
+        mon_println("mtb: not found (set it with 'mtb base <addr>')");
+        return false;
+    }
+    mon_puts("mtb at ");
+    mon_put_hex(info.base);
+    mon_puts(info.enabled ? " on, sram " : " off, sram ");
+    mon_put_hex(info.sram_base);
+    mon_flush();
+    if (info.window) {
+        mon_puts("window ");
+        mon_put_hex(info.window);
+        mon_puts(" ");
+        mon_put_dec(info.size);
+        mon_puts(" bytes, position ");
+        mon_put_hex(info.position);
+        mon_flush();
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+static bool mon_coverage(uint32_t argc, char **argv)
+{
+    if (argc >= 2u && strcmp(argv[1], "start") == 0) {
+        uint32_t base  = 0;
+        uint32_t size  = 0;
+        uint32_t shift = 0;
+        if (argc < 4u || argc > 5u || !mon_parse_u32(argv[2], &base) || !mon_parse_u32(argv[3], &size) ||
+            (argc == 5u && !mon_parse_u32(argv[4], &shift))) {
+            mon_println("usage: coverage start <addr> <size> [<shift>]");
+            return false;
+        }
+        if (!coverage_start(base, size, shift)) {
+            mon_println("coverage: range too large for the bitmap, or no MTB window (see 'mtb')");
+            return false;
+        }
+        return true;
+    }
+    if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        coverage_stop();
+        return true;
+    }
+    bool dump = (argc == 2u && strcmp(argv[1], "dump") == 0);
+    if (argc != 1u && !dump) {
+        mon_println("usage: coverage [start <addr> <size> [<shift>] | stop | dump]");
+        return false;
+    }
+
+    coverage_stats_t st;
+    coverage_get(&st);
+    if (dump) {
+        uint32_t cursor = 0;
+        uint32_t begin  = 0;
+        uint32_t end    = 0;
+        while (coverage_next_range(&cursor, &begin, &end)) {
+            mon_put_hex(begin);
+            mon_puts(" ");
+            mon_put_hex(end);
+            mon_flush();
+        }
+    }
+    mon_puts(coverage_active() ? "coverage on: " : "coverage off: ");
+    mon_put_dec(st.covered);
+    mon_puts("/");
+    mon_put_dec(st.granules);
+    mon_puts(" x ");
+    mon_put_dec(1u << st.shift);
+    mon_puts(" bytes from ");
+    mon_put_hex(st.base);
+    mon_flush();
+    mon_put_dec(st.drains);
+    mon_puts(" drains, ");
+    mon_put_dec(st.packets);
+    mon_puts(" branches, ");
+    mon_put_dec(st.overflows);
+    mon_puts(" overflows, ");
+    mon_put_dec(st.dropped);
+    mon_println(" dropped");
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_RTT) && (PROBE_ENABLE_RTT)
+static bool mon_rtt(uint32_t argc, char **argv)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    if (argc >= 2u && strcmp(argv[1], "scan") == 0) {
+        if (argc != 4u || !mon_parse_u32(argv[2], &a) || !mon_parse_u32(argv[3], &b)) {
+            mon_println("usage: rtt scan <start> <size>");
+            return false;
+        }
+        if (!rtt_scan(a, b)) {
+            mon_println("rtt: no control block found");
+            return false;
+        }
+    } else if (argc >= 2u && strcmp(argv[1], "write") == 0) {
+        // Words are rejoined with single spaces; a newline ends the line like a terminal would.
+        for (uint32_t i = 2; i < argc; i++) {
+            const char *sep = (i + 1u < argc) ? " " : "\n";
+            if (!rtt_write((const uint8_t *) argv[i], (uint32_t) strlen(argv[i])) ||
+                !rtt_write((const uint8_t *) sep, 1u)) {
+                mon_println("rtt: down-buffer 0 full or missing");
+                return false;
+            }
+        }
+        return true;
+    } else if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        rtt_detach();
+        return true;
+    } else if (argc == 2u) {
+        if (!mon_parse_u32(argv[1], &a) || !rtt_attach(a)) {
+            mon_println("rtt: no control block at that address");
+            return false;
+        }
+    } else if (argc != 1u) {
+        mon_println("usage: rtt [<addr> | scan <start> <size> | write <text> | stop]");
+        return false;
+    }
+
+    rtt_stats_t st;
+    rtt_get(&st);
+    if (!st.addr) {
+        mon_println("rtt off");
+        return true;
+    }
+    mon_puts("rtt at ");
+    mon_put_hex(st.addr);
+    mon_puts(": ");
+    mon_put_dec(st.num_up);
+    mon_puts(" up, ");
+    mon_put_dec(st.num_down);
+    mon_puts(" down, poll ");
+    mon_put_dec(st.period_us);
+    mon_println(" us");
+    mon_put_dec(st.bytes_up);
+    mon_puts(" bytes up, ");
+    mon_put_dec(st.bytes_down);
+    mon_println(" bytes down");
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+static bool mon_swo(uint32_t argc, char **argv)
+{
+    uint32_t clk  = 0;
+    uint32_t baud = 0;
+    uint32_t mask = 1u;
+    bool     exc  = false;
+
+    if (argc >= 2u && strcmp(argv[1], "start") == 0) {
+        if (argc < 4u || !mon_parse_u32(argv[2], &clk) || !mon_parse_u32(argv[3], &baud) ||
+            (argc >= 5u && !mon_parse_u32(argv[4], &mask)) || (argc == 6u && strcmp(argv[5], "exc") != 0)) {
+            mon_println("usage: swo start <trace_clk_hz> <baud> [<port_mask> [exc]]");
+            return false;
+        }
+        exc = (argc == 6u);
+        if (!swo_start(clk, baud, mask, exc)) {
+            mon_println("swo: baud out of range or target has no ITM/TPIU");
+            return false;
+        }
+    } else if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        swo_stop();
+    } else if (argc != 1u) {
+        mon_println("usage: swo [start <trace_clk_hz> <baud> [<port_mask> [exc]] | stop]");
+        return false;
+    }
+
+    swo_stats_t st;
+    swo_get(&st);
+    mon_puts(st.running ? "swo on, " : "swo off, ");
+    mon_put_dec(st.baud);
+    mon_puts(" baud (prescaler ");
+    mon_put_dec(st.prescaler);
+    mon_puts("), ports ");
+    mon_put_hex(st.port_mask);
+    mon_println(st.exc_trace ? ", exception trace" : "");
+    mon_put_dec(st.bytes);
+    mon_puts(" bytes, ");
+    mon_put_dec(st.text);
+    mon_puts(" text, ");
+    mon_put_dec(st.stimulus);
+    mon_puts(" other ports, ");
+    mon_put_dec(st.overflows);
+    mon_puts(" overflows, ");
+    mon_put_dec(st.dropped);
+    mon_println(" dropped");
+
+    uint32_t num = 0;
+    uint32_t cnt = 0;
+    for (uint32_t i = 0; swo_exc_get(i, &num, &cnt); i++) {
+        mon_puts("exc ");
+        mon_put_dec(num);
+        mon_puts(": ");
+        mon_put_dec(cnt);
+        mon_println("");
+    }
+    if (st.exc_other) {
+        mon_puts("other: ");
+        mon_put_dec(st.exc_other);
+        mon_println("");
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_LIVE_WATCH) && (PROBE_ENABLE_LIVE_WATCH)
+static bool mon_live(uint32_t argc, char **argv)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    if (argc >= 2u && strcmp(argv[1], "add") == 0) {
+        if (argc != 4u || !mon_parse_u32(argv[2], &a) || !mon_parse_u32(argv[3], &b) || !live_add(a, b)) {
+            mon_println("usage: live add <addr> <len>  (up to 8 regions, 64 bytes in total)");
+            return false;
+        }
+    } else if (argc >= 2u && strcmp(argv[1], "start") == 0) {
+        if (argc != 3u || !mon_parse_u32(argv[2], &a) || !live_start(a)) {
+            mon_println("usage: live start <rate_hz>  (after live add)");
+            return false;
+        }
+    } else if (argc == 2u && strcmp(argv[1], "stop") == 0) {
+        live_stop();
+    } else if (argc == 2u && strcmp(argv[1], "clear") == 0) {
+        live_clear();
+        return true;
+    } else if (argc != 1u) {
+        mon_println("usage: live [add <addr> <len> | start <rate_hz> | stop | clear]");
+        return false;
+    }
+
+    live_stats_t st;
+    live_get(&st);
+    for (uint32_t i = 0; live_region(i, &a, &b); i++) {
+        mon_puts("live ");
+        mon_put_dec(i);
+        mon_puts(": ");
+        mon_put_hex(a);
+        mon_puts(" len ");
+        mon_put_dec(b);
+        mon_println("");
+    }
+    mon_puts(st.running ? "live on, " : "live off, ");
+    mon_put_dec(st.rate_hz);
+    mon_puts(" Hz, ");
+    mon_put_dec(st.frames);
+    mon_puts(" frames, ");
+    mon_put_dec(st.skipped);
+    mon_puts(" skipped, ");
+    mon_put_dec(st.errors);
+    mon_println(" read errors");
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+static bool mon_stub(uint32_t argc, char **argv)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    if (argc >= 2u && strcmp(argv[1], "ram") == 0) {
+        if (argc != 4u || !mon_parse_u32(argv[2], &a) || !mon_parse_u32(argv[3], &b) || !cortex_stub_set_ram(a, b)) {
+            mon_println("usage: stub ram <addr> <size>  (word-aligned, up to 256 bytes used)");
+            return false;
+        }
+    } else if (argc == 2u && strcmp(argv[1], "off") == 0) {
+        (void) cortex_stub_set_ram(0u, 0u);
+    } else if (argc != 1u) {
+        mon_println("usage: stub [ram <addr> <size> | off]");
+        return false;
+    }
+
+    if (!cortex_stub_get_ram(&a, &b)) {
+        mon_println("stub off");
+        return true;
+    }
+    mon_puts("stub ram ");
+    mon_put_hex(a);
+    mon_puts(" len ");
+    mon_put_dec(b);
+    mon_println("");
+    return true;
+}
+
+static bool mon_fill(uint32_t argc, char **argv)
+{
+    uint32_t addr = 0;
+    uint32_t len  = 0;
+    uint32_t v    = 0;
+
+    if ((argc != 3u && argc != 4u) || !mon_parse_u32(argv[1], &addr) || !mon_parse_u32(argv[2], &len) ||
+        (argc == 4u && (!mon_parse_u32(argv[3], &v) || v > 0xFFu))) {
+        mon_println("usage: fill <addr> <len> [<byte>]");
+        return false;
+    }
+    if (cortex_stub_memset(addr, (uint8_t) v, len)) {
+        return true;
+    }
+    if (cortex_stub_faulted()) {
+        mon_println("fill: stub faulted on the target (HardFault active), reset the target");
+        return false;
+    }
+
+    // No stub window (or the target is running): write the fill over SWD.
+    uint8_t buf[32];
+    memset(buf, (int) v, sizeof(buf));
+    while (len) {
+        uint32_t n = (len > sizeof(buf)) ? (uint32_t) sizeof(buf) : len;
+        if (!target_mem_write_bytes(addr, buf, n)) {
+            mon_println("fill: write failed");
+            return false;
+        }
+        addr += n;
+        len -= n;
+    }
+    return true;
+}
+#endif
+
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+static bool mon_flash(uint32_t argc, char **argv)
+{
+    uint32_t v[6] = {0};
+    bool     args = argc >= 3u;
+
+    for (uint32_t i = 2; i < argc; i++) {
+        args = args && mon_parse_u32(argv[i], &v[i - 2u]);
+    }
+    if (argc >= 2u && strcmp(argv[1], "region") == 0) {
+        if (argc != 6u || !args || !flash_set_region(v[0], v[1], v[2], v[3])) {
+            mon_println("usage: flash region <start> <size> <sector> <page>  (powers of two, page <= sector)");
+            return false;
+        }
+    } else if (argc >= 2u && strcmp(argv[1], "algo") == 0) {
+        if ((argc != 6u && argc != 7u) || !args || !flash_set_algo(v[0], v[1], v[2], v[3], v[4])) {
+            mon_println("usage: flash algo <init> <uninit> <erase> <program> [<static_base>]");
+            return false;
+        }
+    } else if (argc >= 2u && strcmp(argv[1], "ram") == 0) {
+        if (argc != 4u || !args || !flash_set_ram(v[0], v[1])) {
+            mon_println("usage: flash ram <addr> <size>  (word-aligned)");
+            return false;
+        }
+    } else if (argc != 1u) {
+        mon_println("usage: flash [region <start> <size> <sector> <page> | algo <init> <uninit> <erase> <program> "
+                    "[<sb>] | ram <addr> <size>]");
+        return false;
+    }
+
+    flash_config_t c;
+    bool           ready = flash_get_config(&c);
+    mon_puts("flash ");
+    mon_put_hex(c.start);
+    mon_puts(" len ");
+    mon_put_dec(c.size);
+    mon_puts(" sector ");
+    mon_put_dec(c.sector);
+    mon_puts(" page ");
+    mon_put_dec(c.page);
+    mon_println("");
+    mon_puts("algo init ");
+    mon_put_hex(c.init);
+    mon_puts(" uninit ");
+    mon_put_hex(c.uninit);
+    mon_puts(" erase ");
+    mon_put_hex(c.erase);
+    mon_puts(" program ");
+    mon_put_hex(c.program);
+    mon_puts(" sb ");
+    mon_put_hex(c.sb);
+    mon_println("");
+    mon_puts("ram ");
+    mon_put_hex(c.ram);
+    mon_puts(" len ");
+    mon_put_dec(c.ram_size);
+    if (ready) {
+        mon_println(", ready (reconnect GDB to load the memory map)");
+    } else {
+        mon_puts(", not ready (needs region, algo and ram >= ");
+        mon_put_dec(flash_ram_needed(c.page));
+        mon_println(" bytes)");
+    }
+    return true;
+}
+#endif
+
+static const monitor_cmd_t g_monitor_cmds[] = {
+    {"help", mon_help, "list monitor commands"},
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+    {"watchval", mon_watchval, "[<addr> <value> | clear [<addr>]]  halt watch at addr only on value"},
+#endif
+#if defined(PROBE_ENABLE_POLL_WATCH) && (PROBE_ENABLE_POLL_WATCH)
+    {"pollwatch", mon_pollwatch, "[<addr> <value> [<mask> [<period_us>]] | clear]  halt when polled word matches"},
+#endif
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+    {"profile", mon_profile, "[<top_n> | start [<period_us> [<bin_shift>]] | stop | clear]  PC sampling"},
+#endif
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    {"time", mon_time, "[<start> <end> [<iterations>] | stop]  cycle timing between two addresses"},
+#endif
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+    {"perfcounters", mon_perfcounters, "[start [<period_us>] | stop]  DWT CPI/EXC/SLEEP/LSU/FOLD counters"},
+#endif
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+    {"mtb", mon_mtb, "[base <addr> | window <addr> <size> | on | off]  Micro Trace Buffer setup"},
+#endif
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+    {"coverage", mon_coverage, "[start <addr> <size> [<shift>] | stop | dump]  MTB code coverage"},
+#endif
+#if defined(PROBE_ENABLE_RTT) && (PROBE_ENABLE_RTT)
+    {"rtt", mon_rtt, "[<addr> | scan <start> <size> | write <text> | stop]  RTT console channel"},
+#endif
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+    {"swo", mon_swo, "[start <trace_clk_hz> <baud> [<port_mask> [exc]] | stop]  SWO/ITM capture"},
+#endif
+#if defined(PROBE_ENABLE_LIVE_WATCH) && (PROBE_ENABLE_LIVE_WATCH)
+    {"live", mon_live, "[add <addr> <len> | start <rate_hz> | stop | clear]  stream memory while running"},
+#endif
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+    {"stub", mon_stub, "[ram <addr> <size> | off]  scratch RAM for target-resident helper stubs"},
+    {"fill", mon_fill, "<addr> <len> [<byte>]  fill target memory (runs on the target with a stub window)"},
+#endif
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+    {"flash", mon_flash, "[region <start> <size> <sector> <page> | algo <init> <uninit> <erase> <program> [<sb>] | ram <addr> <size>]  RAM flash algorithm"},
+#endif
+};
+
+#define MONITOR_NUM_CMDS (sizeof(g_monitor_cmds) / sizeof(g_monitor_cmds[0]))
+
+static bool mon_help(uint32_t argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    for (uint32_t i = 0; i < MONITOR_NUM_CMDS; i++) {
+        mon_puts(g_monitor_cmds[i].name);
+        mon_puts(" ");
+        mon_println(g_monitor_cmds[i].help);
+    }
+    return true;
+}
+
+bool monitor_command(char *line)
+{
+    char    *argv[MONITOR_MAX_ARGS];
+    uint32_t argc = 0;
+
+    g_mon_len = 0;
+    while (*line && argc < MONITOR_MAX_ARGS) {
+        while (*line == ' ') {
+            line++;
+        }
+        if (*line == '\0') {
+            break;
+        }
+        argv[argc++] = line;
+        while (*line && *line != ' ') {
+            line++;
+        }
+        if (*line) {
+            *line++ = '\0';
+        }
+    }
+    if (argc == 0u) {
+        return mon_help(0u, NULL);
+    }
+
+    for (uint32_t i = 0; i < MONITOR_NUM_CMDS; i++) {
+        if (strcmp(argv[0], g_monitor_cmds[i].name) == 0) {
+            return g_monitor_cmds[i].fn(argc, argv);
+        }
+    }
+
+    mon_puts("unknown command: ");
+    mon_println(argv[0]);
+    return false;
+}
@@ -0,0 +1,381 @@
+// Micro Trace Buffer readout and GDB branch trace (see mtb.h).
+
+#include "mtb.h"
+
+#include "adiv5.h"
+#include "cortex.h"
+#include "target.h"
+#include "target_mem.h"
+
+// MTB registers
+#define MTB_POSITION 0x000u
+#define MTB_MASTER   0x004u
+#define MTB_FLOW     0x008u
+#define MTB_BASE     0x00Cu
+
+#define MTB_POSITION_WRAP (1u << 2)
+#define MTB_MASTER_EN     (1u << 31)
+#define MTB_MASTER_HALTREQ (1u << 9)
+#define MTB_FLOW_AUTOHALT  (1u << 1)
+#define MTB_MASTER_MASK   0x1Fu  // window = 2^(MASK+4) bytes
+
+// CoreSight identification
+#define CS_PIDR0      0xFE0u
+#define CS_PIDR1      0xFE4u
+#define CS_CIDR1      0xFF4u
+#define CS_CLASS_ROM  0x1u
+#define CS_PART_MTB   0x932u  // MTB-M0+
+#define AP_BASE       0xF8u
+#define ROM_MAX_ENTRY 64u
+#define ROM_MAX_DEPTH 3u
+
+// One block per packet: <block begin="0x%08x" end="0x%08x"/>\n
+#define BTRACE_LINE_LEN    45u
+#define BTRACE_CACHE_LINES 16u
+
+static const char k_btrace_head[] = "<!DOCTYPE btrace SYSTEM \"btrace.dtd\">\n<btrace version=\"1.0\">\n";
+static const char k_btrace_tail[] = "</btrace>\n";
+
+static uint32_t g_base      = 0;
+static uint32_t g_sram_base = 0;
+static uint32_t g_window    = 0;
+static uint32_t g_size      = 0;
+static bool     g_enabled   = false;
+static bool     g_autohalt  = false;  // coverage mode: FLOW watermark halts the core
+
+// Trace snapshot taken at the start of a qXfer:btrace:read.
+static uint32_t g_snap_count  = 0;  // packets in the buffer
+static uint32_t g_snap_oldest = 0;  // window offset of the oldest packet
+static uint32_t g_snap_pc     = 0;
+
+// Raw words for BTRACE_CACHE_LINES consecutive blocks (see btrace_line).
+static uint32_t g_cache[2u * BTRACE_CACHE_LINES];
+static uint32_t g_cache_first = 0;
+static uint32_t g_cache_lines = 0;
+
+static bool rom_walk(uint32_t table, uint32_t depth)
+{
+    for (uint32_t i = 0; i < ROM_MAX_ENTRY; i++) {
+        uint32_t entry = 0;
+        if (!target_mem_read_word(table + 4u * i, &entry) || entry == 0u) {
+            return false;
+        }
+        if (!(entry & 1u)) {
+            continue;  // not present
+        }
+        uint32_t comp  = table + (entry & 0xFFFFF000u);  // signed offset, wraps as intended
+        uint32_t cidr1 = 0;
+        uint32_t pidr0 = 0;
+        uint32_t pidr1 = 0;
+        if (!target_mem_read_word(comp + CS_CIDR1, &cidr1)) {
+            continue;
+        }
+        if (((cidr1 >> 4) & 0xFu) == CS_CLASS_ROM) {
+            // Vendor tables usually nest the Cortex-M0+ table with the MTB beside it.
+            if (depth + 1u < ROM_MAX_DEPTH && comp != table && rom_walk(comp, depth + 1u)) {
+                return true;
+            }
+            continue;
+        }
+        if (target_mem_read_word(comp + CS_PIDR0, &pidr0) && target_mem_read_word(comp + CS_PIDR1, &pidr1) &&
+            ((pidr0 & 0xFFu) | ((pidr1 & 0xFu) << 8)) == CS_PART_MTB) {
+            g_base = comp;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool mtb_discover(void)
+{
+    uint32_t ap_base = 0;
+    if (g_base) {
+        return true;
+    }
+    if (!cortex_is_connected() || !adiv5_ap_read(target_mem_get_ap(), AP_BASE, &ap_base)) {
+        return false;
+    }
+    // 0xFFFFFFFF (legacy) or format=1 with present=0: no debug components.
+    if (ap_base == 0xFFFFFFFFu || (ap_base & 3u) == 2u) {
+        return false;
+    }
+    return rom_walk(ap_base & 0xFFFFF000u, 0u);
+}
+
+void mtb_set_base(uint32_t base)
+{
+    mtb_disable();
+    g_base   = base;
+    g_window = 0;
+    g_size   = 0;
+}
+
+static bool mtb_ready(void)
+{
+    return mtb_discover() && target_mem_read_word(g_base + MTB_BASE, &g_sram_base);
+}
+
+static uint32_t mtb_mask_for(uint32_t size)
+{
+    uint32_t mask = 0;
+    while ((16u << mask) < size) {
+        mask++;
+    }
+    return mask;
+}
+
+static bool mtb_program(bool autohalt)
+{
+    uint32_t master = 0;
+    uint32_t pos    = 0;
+    if (!mtb_ready() || !target_mem_read_word(g_base + MTB_MASTER, &master)) {
+        return false;
+    }
+    if (!g_window) {
+        // Adopt a window the firmware set up and enabled itself (e.g. a reserved section).
+        if (!(master & MTB_MASTER_EN) || !target_mem_read_word(g_base + MTB_POSITION, &pos)) {
+            return false;
+        }
+        g_size   = 16u << (master & MTB_MASTER_MASK);
+        g_window = g_sram_base + (pos & ~(g_size - 1u));
+    }
+
+    // Watermark at three quarters of the window leaves room for the branches that
+    // retire while the halt request takes effect.
+    uint32_t mask = mtb_mask_for(g_size);
+    uint32_t ptr  = g_window - g_sram_base;
+    uint32_t flow = autohalt ? (((ptr + g_size - g_size / 4u) & ~7u) | MTB_FLOW_AUTOHALT) : 0u;
+    if (!target_mem_write_word(g_base + MTB_MASTER, mask) ||
+        !target_mem_write_word(g_base + MTB_POSITION, ptr) ||
+        !target_mem_write_word(g_base + MTB_FLOW, flow) ||
+        !target_mem_write_word(g_base + MTB_MASTER, MTB_MASTER_EN | mask) ||
+        !target_mem_read_word(g_base + MTB_MASTER, &master)) {
+        return false;
+    }
+    if ((master & MTB_MASTER_MASK) != mask) {
+        // The MTB implements fewer MASK bits than the window needs.
+        (void) target_mem_write_word(g_base + MTB_MASTER, 0u);
+        g_enabled = false;
+        return false;
+    }
+    g_enabled  = true;
+    g_autohalt = autohalt;
+    return true;
+}
+
+bool mtb_enable(void)
+{
+    // Branch trace and coverage share the buffer; coverage drains it on every halt.
+    return !(g_enabled && g_autohalt) && mtb_program(false);
+}
+
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+bool mtb_enable_autohalt(void) { return mtb_program(true); }
+#endif
+
+bool mtb_set_window(uint32_t addr, uint32_t size)
+{
+    if (size < 16u || (size & (size - 1u)) || !mtb_ready() || addr < g_sram_base ||
+        ((addr - g_sram_base) & (size - 1u))) {
+        return false;
+    }
+    g_window = addr;
+    g_size   = size;
+    return g_enabled ? mtb_program(g_autohalt) : true;
+}
+
+void mtb_disable(void)
+{
+    if (g_enabled) {
+        g_enabled  = false;
+        g_autohalt = false;
+        (void) target_mem_write_word(g_base + MTB_MASTER, 0u);
+    }
+}
+
+bool mtb_enabled(void) { return g_enabled; }
+
+bool mtb_get_info(mtb_info_t *out)
+{
+    out->base      = 0;
+    out->sram_base = 0;
+    out->window    = g_window;
+    out->size      = g_size;
+    out->position  = 0;
+    out->enabled   = g_enabled;
+    if (!mtb_ready()) {
+        return false;
+    }
+    out->base      = g_base;
+    out->sram_base = g_sram_base;
+    return target_mem_read_word(g_base + MTB_POSITION, &out->position);
+}
+
+static bool mtb_snapshot(void)
+{
+    uint32_t pos = 0;
+    if (!target_mem_read_word(g_base + MTB_POSITION, &pos) || !target_read_pc(&g_snap_pc)) {
+        return false;
+    }
+    uint32_t ptr = pos & ~7u & (g_size - 1u);
+    if (pos & MTB_POSITION_WRAP) {
+        g_snap_count  = g_size / 8u;
+        g_snap_oldest = ptr;
+    } else {
+        g_snap_count  = ptr / 8u;
+        g_snap_oldest = 0;
+    }
+    g_cache_lines = 0;
+    return true;
+}
+
+// Word w of the trace, oldest first: packet k is source 2k, destination 2k+1.
+static bool mtb_read_words(uint32_t oldest, uint32_t first, uint32_t count, uint32_t *out)
+{
+    while (count) {
+        uint32_t off = (oldest + 4u * first) & (g_size - 1u);
+        uint32_t run = (g_size - off) / 4u;
+        if (run > count) {
+            run = count;
+        }
+        if (!target_mem_read_block(g_window + off, out, run)) {
+            return false;
+        }
+        first += run;
+        out += run;
+        count -= run;
+    }
+    return true;
+}
+
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+bool mtb_drain(mtb_packet_fn fn, bool *out_watermark)
+{
+    uint32_t pos    = 0;
+    uint32_t master = 0;
+    uint32_t words[16];
+
+    *out_watermark = false;
+    if (!g_enabled || !target_mem_read_word(g_base + MTB_POSITION, &pos) ||
+        !target_mem_read_word(g_base + MTB_MASTER, &master)) {
+        return false;
+    }
+    uint32_t ptr    = pos & ~7u & (g_size - 1u);
+    bool     wrap   = (pos & MTB_POSITION_WRAP) != 0u;
+    uint32_t oldest = wrap ? ptr : 0u;
+    uint32_t count  = wrap ? (g_size / 8u) : (ptr / 8u);
+
+    for (uint32_t k = 0; k < count; k += 8u) {
+        uint32_t m = (count - k < 8u) ? (count - k) : 8u;
+        if (!mtb_read_words(oldest, 2u * k, 2u * m, words)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < m; i++) {
+            fn(words[2u * i], words[2u * i + 1u], wrap && k == 0u && i == 0u);
+        }
+    }
+
+    // Restart at the bottom of the window and drop the watermark's halt request.
+    if (!target_mem_write_word(g_base + MTB_POSITION, g_window - g_sram_base)) {
+        return false;
+    }
+    if (master & MTB_MASTER_HALTREQ) {
+        *out_watermark = true;
+        return target_mem_write_word(g_base + MTB_MASTER, master & ~MTB_MASTER_HALTREQ);
+    }
+    return true;
+}
+#endif
+
+static void put_hex8(char *p, uint32_t v)
+{
+    for (uint32_t i = 0; i < 8u; i++) {
+        p[i] = "0123456789abcdef"[(v >> (28u - 4u * i)) & 0xFu];
+    }
+}
+
+// GDB wants blocks newest first: block j runs from the destination of packet n-1-j to
+// the source of packet n-j (the current PC for j = 0). Those two words are adjacent,
+// so a run of blocks is one contiguous (circular) range of trace words.
+static bool btrace_line(uint32_t j, char *line)
+{
+    uint32_t n = g_snap_count;
+    if (j < g_cache_first || j >= g_cache_first + g_cache_lines) {
+        uint32_t m = n - j;
+        if (m > BTRACE_CACHE_LINES) {
+            m = BTRACE_CACHE_LINES;
+        }
+        if (!mtb_read_words(g_snap_oldest, 2u * (n - j - m) + 1u, 2u * m - ((j == 0u) ? 1u : 0u), g_cache)) {
+            return false;
+        }
+        g_cache_first = j;
+        g_cache_lines = m;
+    }
+    uint32_t k     = 2u * (g_cache_lines - (j - g_cache_first)) - 2u;
+    uint32_t begin = g_cache[k] & ~1u;  // bit 0 is the S (trace start) flag
+    uint32_t end   = (j == 0u) ? g_snap_pc : (g_cache[k + 1u] & ~1u);  // bit 0 is the A (exception) flag
+
+    static const char k_tmpl[] = "<block begin=\"0x00000000\" end=\"0x00000000\"/>\n";
+    for (uint32_t i = 0; i < BTRACE_LINE_LEN; i++) {
+        line[i] = k_tmpl[i];
+    }
+    put_hex8(&line[16], begin);
+    put_hex8(&line[33], end);
+    return true;
+}
+
+bool mtb_btrace_read(uint32_t off, char *out, uint32_t len, uint32_t *out_len, bool *out_more)
+{
+    if (!g_enabled || g_autohalt || (off == 0u && !mtb_snapshot())) {
+        return false;
+    }
+    uint32_t head  = sizeof(k_btrace_head) - 1u;
+    uint32_t body  = g_snap_count * BTRACE_LINE_LEN;
+    uint32_t total = head + body + (sizeof(k_btrace_tail) - 1u);
+    uint32_t n     = 0;
+
+    while (n < len && off < total) {
+        if (off < head) {
+            out[n++] = k_btrace_head[off++];
+        } else if (off < head + body) {
+            char     line[BTRACE_LINE_LEN];
+            uint32_t col = (off - head) % BTRACE_LINE_LEN;
+            if (!btrace_line((off - head) / BTRACE_LINE_LEN, line)) {
+                return false;
+            }
+            while (col < BTRACE_LINE_LEN && n < len) {
+                out[n++] = line[col++];
+                off++;
+            }
+        } else {
+            out[n++] = k_btrace_tail[off - head - body];
+            off++;
+        }
+    }
+    *out_len  = n;
+    *out_more = off < total;
+    return true;
+}
+
+bool mtb_btrace_conf_read(uint32_t off, char *out, uint32_t len, uint32_t *out_len, bool *out_more)
+{
+    static const char k_conf[] = "<!DOCTYPE btrace-conf SYSTEM \"btrace-conf.dtd\">\n<btrace-conf version=\"1.0\">\n"
+                                 "<bts size=\"0x00000000\"/>\n</btrace-conf>\n";
+    char     doc[sizeof(k_conf)];
+    uint32_t total = sizeof(k_conf) - 1u;
+    uint32_t n     = 0;
+
+    if (!g_enabled) {
+        return false;
+    }
+    for (uint32_t i = 0; i < sizeof(k_conf); i++) {
+        doc[i] = k_conf[i];
+    }
+    put_hex8(&doc[total - 27u], g_size);  // the size digits end 19 bytes before the end
+    while (n < len && off < total) {
+        out[n++] = doc[off++];
+    }
+    *out_len  = n;
+    *out_more = off < total;
+    return true;
+}
@@ -0,0 +1,88 @@
+// DWT event counter sampling (see perfcnt.h).
+
+#include "perfcnt.h"
+
+#include "cortex.h"
+#include "hal.h"
+
+static perfcnt_stats_t g_pc;
+static bool            g_running   = false;
+static uint32_t        g_period_us = 0;
+static uint32_t        g_last_us   = 0;
+static uint32_t        g_rem_us    = 0;  // sub-millisecond remainder of elapsed time
+static bool            g_halted    = false;  // target stopped since the last sample
+static uint32_t        g_last[PERFCNT_NUM];
+
+bool perfcnt_start(uint32_t period_us)
+{
+    if (!cortex_perf_enable(true) || !cortex_perf_read(g_last)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < PERFCNT_NUM; i++) {
+        g_pc.total[i]     = 0;
+        g_pc.max_delta[i] = 0;
+    }
+    g_pc.elapsed_ms = 0;
+    g_pc.polls      = 0;
+    g_period_us     = period_us;
+    g_last_us       = hal_time_us();
+    g_rem_us        = 0;
+    g_halted        = false;
+    g_running       = true;
+    return true;
+}
+
+void perfcnt_stop(void)
+{
+    if (g_running) {
+        g_running = false;
+        (void) cortex_perf_enable(false);
+    }
+}
+
+bool perfcnt_running(void) { return g_running; }
+
+void perfcnt_poll(bool halted)
+{
+    if (!g_running) {
+        return;
+    }
+    if (halted) {
+        g_halted = true;
+        return;
+    }
+    uint32_t now = hal_time_us();
+    uint32_t dt  = now - g_last_us;
+    if (dt < g_period_us) {
+        return;
+    }
+
+    uint32_t cur[PERFCNT_NUM];
+    if (!cortex_perf_read(cur)) {
+        return;
+    }
+    g_last_us = now;
+
+    // The counters stop while the core is halted, so a gap that spans a halt (the target
+    // was stopped in GDB) only contributes up to one period of time.
+    uint32_t cap = (g_period_us > 1000u) ? 2u * g_period_us : 2000u;
+    g_rem_us += (g_halted && dt > cap) ? cap : dt;
+    g_halted = false;
+    g_pc.elapsed_ms += g_rem_us / 1000u;
+    g_rem_us %= 1000u;
+
+    g_pc.total[0] += cur[0] - g_last[0];
+    for (uint32_t i = 1; i < PERFCNT_NUM; i++) {
+        uint8_t d = (uint8_t) (cur[i] - g_last[i]);
+        g_pc.total[i] += d;
+        if (d > g_pc.max_delta[i]) {
+            g_pc.max_delta[i] = d;
+        }
+    }
+    for (uint32_t i = 0; i < PERFCNT_NUM; i++) {
+        g_last[i] = cur[i];
+    }
+    g_pc.polls++;
+}
+
+void perfcnt_get(perfcnt_stats_t *out) { *out = g_pc; }
@@ -0,0 +1,73 @@
+// Background polled value watch (see pollwatch.h).
+
+#include "pollwatch.h"
+
+#include "hal.h"
+#include "target.h"
+
+typedef struct {
+    uint32_t addr;
+    uint32_t value;
+    uint32_t mask;
+    uint32_t period_us;
+    uint32_t last_us;
+    bool     armed;
+} pollwatch_t;
+
+static pollwatch_t g_pollwatch;
+
+bool pollwatch_set(uint32_t addr, uint32_t value, uint32_t mask, uint32_t period_us)
+{
+    if (mask == 0u) {
+        return false;
+    }
+    g_pollwatch.addr      = addr;
+    g_pollwatch.value     = value & mask;
+    g_pollwatch.mask      = mask;
+    g_pollwatch.period_us = period_us;
+    g_pollwatch.last_us   = hal_time_us();
+    g_pollwatch.armed     = true;
+    return true;
+}
+
+void pollwatch_clear(void) { g_pollwatch.armed = false; }
+
+bool pollwatch_get(uint32_t *out_addr, uint32_t *out_value, uint32_t *out_mask, uint32_t *out_period_us)
+{
+    if (!g_pollwatch.armed) {
+        return false;
+    }
+    *out_addr      = g_pollwatch.addr;
+    *out_value     = g_pollwatch.value;
+    *out_mask      = g_pollwatch.mask;
+    *out_period_us = g_pollwatch.period_us;
+    return true;
+}
+
+bool pollwatch_poll(uint32_t *out_addr)
+{
+    if (!g_pollwatch.armed) {
+        return false;
+    }
+    uint32_t now = hal_time_us();
+    if ((now - g_pollwatch.last_us) < g_pollwatch.period_us) {
+        return false;
+    }
+    g_pollwatch.last_us = now;
+
+    // Little-endian word assembled from bytes, so unaligned addresses work too.
+    uint8_t b[4];
+    if (!target_mem_read_bytes(g_pollwatch.addr, b, sizeof(b))) {
+        return false;  // bus busy or no background access; try again next period
+    }
+    uint32_t v = (uint32_t) b[0] | ((uint32_t) b[1] << 8) | ((uint32_t) b[2] << 16) | ((uint32_t) b[3] << 24);
+    if ((v & g_pollwatch.mask) != g_pollwatch.value) {
+        return false;
+    }
+
+    if (!target_halt()) {
+        return false;
+    }
+    *out_addr = g_pollwatch.addr;
+    return true;
+}
@@ -0,0 +1,131 @@
+// PC sampling profiler (see profile.h).
+
+#include "profile.h"
+
+#include "hal.h"
+#include "target.h"
+
+#ifndef PROFILE_BINS
+#define PROFILE_BINS 64u  // power of two; 8 bytes of RAM each
+#endif
+
+typedef struct {
+    uint32_t key;    // pc >> shift
+    uint32_t count;  // 0 = empty
+} profile_bin_t;
+
+static profile_bin_t g_bins[PROFILE_BINS];
+static bool          g_enabled   = false;
+static uint32_t      g_period_us = 0;
+static uint32_t      g_shift     = 0;
+static uint32_t      g_last_us   = 0;
+static uint32_t      g_samples   = 0;
+static uint32_t      g_missed    = 0;
+static uint32_t      g_unbinned  = 0;
+
+void profile_clear(void)
+{
+    for (uint32_t i = 0; i < PROFILE_BINS; i++) {
+        g_bins[i].key   = 0;
+        g_bins[i].count = 0;
+    }
+    g_samples  = 0;
+    g_missed   = 0;
+    g_unbinned = 0;
+}
+
+bool profile_start(uint32_t period_us, uint32_t shift)
+{
+    if (shift > 16u) {
+        return false;
+    }
+    // Bins are keyed on pc >> shift, so a new granularity invalidates old data.
+    if (shift != g_shift) {
+        profile_clear();
+    }
+    g_period_us = period_us;
+    g_shift     = shift;
+    g_last_us   = hal_time_us();
+    g_enabled   = true;
+    return true;
+}
+
+void profile_stop(void) { g_enabled = false; }
+
+bool profile_enabled(void) { return g_enabled; }
+
+uint32_t profile_shift(void) { return g_shift; }
+
+static void profile_add(uint32_t pc)
+{
+    uint32_t key = pc >> g_shift;
+    uint32_t h   = (key * 2654435761u) & (PROFILE_BINS - 1u);
+    for (uint32_t n = 0; n < PROFILE_BINS; n++) {
+        profile_bin_t *b = &g_bins[(h + n) & (PROFILE_BINS - 1u)];
+        if (b->count == 0u) {
+            b->key = key;
+        }
+        if (b->key == key) {
+            b->count++;
+            return;
+        }
+    }
+    g_unbinned++;
+}
+
+void profile_poll(void)
+{
+    if (!g_enabled) {
+        return;
+    }
+    uint32_t now = hal_time_us();
+    if ((now - g_last_us) < g_period_us) {
+        return;
+    }
+    g_last_us = now;
+
+    uint32_t pc = 0;
+    if (!target_sample_pc(&pc)) {
+        g_missed++;
+        return;
+    }
+    g_samples++;
+    profile_add(pc);
+}
+
+void profile_totals(uint32_t *out_samples, uint32_t *out_missed, uint32_t *out_unbinned)
+{
+    *out_samples  = g_samples;
+    *out_missed   = g_missed;
+    *out_unbinned = g_unbinned;
+}
+
+bool profile_top(uint32_t rank, uint32_t *out_addr, uint32_t *out_count)
+{
+    // Walk bins in (count desc, index asc) order without sorting the hash table.
+    uint32_t last_count = 0xFFFFFFFFu;
+    uint32_t last_idx   = 0u;
+    for (uint32_t r = 0; r <= rank; r++) {
+        uint32_t best = PROFILE_BINS;
+        for (uint32_t i = 0; i < PROFILE_BINS; i++) {
+            uint32_t c = g_bins[i].count;
+            if (c == 0u) {
+                continue;
+            }
+            if (c > last_count || (c == last_count && i <= last_idx)) {
+                continue;
+            }
+            if (best == PROFILE_BINS || c > g_bins[best].count) {
+                best = i;
+            }
+        }
+        if (best == PROFILE_BINS) {
+            return false;
+        }
+        last_count = g_bins[best].count;
+        last_idx   = best;
+    }
+    *out_addr  = g_bins[last_idx].key << g_shift;
+    *out_count = last_count;
+    return true;
+}
@@ -0,0 +1,109 @@
+// Region timing between two code addresses (see regiontime.h).
+//
+// Each pass costs a halt and a single step at both addresses, so the numbers
+// exclude the first instruction of the region but are otherwise undisturbed:
+// the cycle counter does not run while the core is halted.
+
+#include "regiontime.h"
+
+#include "target.h"
+
+static regiontime_stats_t g_rt;
+static bool               g_active    = false;
+static bool               g_in_region = false;
+static bool               g_has_stats = false;
+static uint32_t           g_t0        = 0;
+static uint64_t           g_sum       = 0;
+
+bool regiontime_start(uint32_t start, uint32_t end, uint32_t iterations)
+{
+    uint32_t cyc = 0;
+    if (iterations == 0u || start == end || !target_cycle_count(&cyc)) {
+        return false;
+    }
+    regiontime_stop();
+    if (!target_probe_breakpoint_insert(start)) {
+        return false;
+    }
+    if (!target_probe_breakpoint_insert(end)) {
+        (void) target_probe_breakpoint_remove(start);
+        return false;
+    }
+
+    g_rt.start      = start;
+    g_rt.end        = end;
+    g_rt.iterations = iterations;
+    g_rt.count      = 0;
+    g_rt.min        = 0xFFFFFFFFu;
+    g_rt.max        = 0;
+    g_rt.mean       = 0;
+    g_sum           = 0;
+    g_in_region     = false;
+    g_active        = true;
+    g_has_stats     = true;
+    return true;
+}
+
+void regiontime_stop(void)
+{
+    if (!g_active) {
+        return;
+    }
+    g_active = false;
+    (void) target_probe_breakpoint_remove(g_rt.start);
+    (void) target_probe_breakpoint_remove(g_rt.end);
+}
+
+bool regiontime_active(void) { return g_active; }
+
+bool regiontime_stats(regiontime_stats_t *out)
+{
+    if (!g_has_stats) {
+        return false;
+    }
+    *out = g_rt;
+    return true;
+}
+
+regiontime_status_t regiontime_on_halt(void)
+{
+    uint32_t pc = 0;
+    if (!g_active || !target_read_pc(&pc) || (pc != g_rt.start && pc != g_rt.end)) {
+        return REGIONTIME_NOT_MINE;
+    }
+    // GDB has its own breakpoint here too: the stop is the user's, and this pass is lost.
+    if (target_breakpoint_at(pc)) {
+        g_in_region = false;
+        return REGIONTIME_NOT_MINE;
+    }
+
+    uint32_t cyc = 0;
+    if (pc == g_rt.end && g_in_region && target_cycle_count(&cyc)) {
+        uint32_t d = cyc - g_t0;
+        g_in_region = false;
+        g_rt.count++;
+        g_sum += d;
+        g_rt.min  = (d < g_rt.min) ? d : g_rt.min;
+        g_rt.max  = (d > g_rt.max) ? d : g_rt.max;
+        g_rt.mean = (uint32_t) (g_sum / g_rt.count);
+        if (g_rt.count >= g_rt.iterations) {
+            regiontime_stop();
+            return REGIONTIME_DONE;
+        }
+    }
+
+    // target_step() lifts our breakpoint to execute the instruction under it.
+    if (!target_step()) {
+        regiontime_stop();
+        return REGIONTIME_NOT_MINE;
+    }
+    // (Re)start the clock after the first instruction of the region has run.
+    if (pc == g_rt.start && target_cycle_count(&g_t0)) {
+        g_in_region = true;
+    }
+    if (!target_continue()) {
+        regiontime_stop();
+        return REGIONTIME_NOT_MINE;
+    }
+    return REGIONTIME_RESUMED;
+}
@@ -45,6 +45,7 @@
 #define DMSTATUS_ANYRESUMEACK   (1u << 16)
 #define DMSTATUS_AUTHENTICATED  (1u << 7)
 #define DMSTATUS_HASRESETHALTREQ (1u << 5)
+#define DMSTATUS_IMPEBREAK      (1u << 22)
 
 // ABSTRACTCS bits
 #define ABSTRACTCS_DATACOUNT_MASK   0x0Fu
@@ -69,8 +70,17 @@
 // Register numbers for abstract commands
 #define REG_GPR_BASE        0x1000u  // x0-x31 = 0x1000-0x101F
 #define REG_CSR_BASE        0x0000u  // CSRs = 0x0000-0x0FFF
+#define REG_DCSR            0x7B0u   // Debug Control and Status (CSR)
 #define REG_DPC             0x7B1u   // Debug PC (CSR)
 
+// dcsr bits
+#define DCSR_EBREAKM        (1u << 15)
+#define DCSR_EBREAKU        (1u << 12)
+#define DCSR_STOPCOUNT      (1u << 10)
+#define DCSR_CAUSE_SHIFT    6
+#define DCSR_CAUSE_MASK     (7u << DCSR_CAUSE_SHIFT)
+#define DCSR_CAUSE_HALTREQ  3u
+
 // SBCS (System Bus Control and Status) bits
 #define SBCS_SBACCESS32     (2u << 17)
 #define SBCS_SBREADONADDR   (1u << 20)
@@ -89,40 +99,88 @@
 #define CMDERR_OTHER        7u
 
 // Trigger Module CSR addresses
+#define CSR_MCYCLE      0xB00u
 #define CSR_TSELECT     0x7A0u
 #define CSR_TDATA1      0x7A1u
 #define CSR_TDATA2      0x7A2u
+#define CSR_TINFO       0x7A4u
+
+// tinfo: bit N set = trigger type N supported
+#define TINFO_MCONTROL  (1u << 2)
 
 // mcontrol (tdata1 type=2) bit fields for RV32
 #define MCONTROL_TYPE_MCONTROL  (2u << 28)
 #define MCONTROL_DMODE          (1u << 27)
 #define MCONTROL_HIT            (1u << 20)
+#define MCONTROL_SELECT         (1u << 19)  // compare tdata2 with the load/store data
 #define MCONTROL_ACTION_DEBUG   (1u << 12)
+#define MCONTROL_CHAIN          (1u << 11)
+#define MCONTROL_MATCH_SHIFT    7
+#define MCONTROL_MATCH_MASK     (0xFu << MCONTROL_MATCH_SHIFT)
+#define MCONTROL_MATCH(m)       ((uint32_t)(m) << MCONTROL_MATCH_SHIFT)
 #define MCONTROL_M              (1u << 6)
 #define MCONTROL_U              (1u << 3)
 #define MCONTROL_EXECUTE        (1u << 2)
 #define MCONTROL_STORE          (1u << 1)
 #define MCONTROL_LOAD           (1u << 0)
 
+// Instruction encodings patched/executed by the probe
+#define RV_EBREAK           0x00100073u
+#define RV_C_EBREAK         0x9002u
+#define RV_FENCE_I          0x0000100Fu
+
 // Timeout for operations (microseconds)
 #define DM_TIMEOUT_US       100000u
 
+// mcontrol match types
+#define MATCH_EQUAL         0u
+#define MATCH_NAPOT         1u
+#define MATCH_GE            2u
+#define MATCH_LT            3u
+
 // Maximum hardware triggers to probe
 #define RISCV_MAX_TRIGGERS  4u
 
+// Per-trigger capabilities (probed by writing tdata1 and reading it back)
+#define TRIG_CAP_NAPOT      (1u << 0)
+#define TRIG_CAP_RANGE      (1u << 1)  // match >= and <
+#define TRIG_CAP_CHAIN      (1u << 2)
+#define TRIG_CAP_DATA       (1u << 3)  // select: data value match
+
 // Trigger slot tracking
 typedef struct {
     uint32_t addr;
-    uint8_t  type;   // 0=unused, 1=breakpoint, 2=watchpoint
+    uint32_t len;
+    uint32_t value;  // data value condition (has_value)
+    uint8_t  type;   // 0=unused, 1=breakpoint, 2=watchpoint, 3=chained tail (range or data value)
     uint8_t  watch;  // TARGET_WATCH_WRITE/READ/ACCESS
+    uint8_t  caps;   // TRIG_CAP_*
     bool     used;
+    bool     has_value;  // only report when the watched bytes equal `value`
+    bool     value_hw;   // value matched by a chained data trigger, not by the probe
 } riscv_trigger_t;
 
 static riscv_trigger_t g_triggers[RISCV_MAX_TRIGGERS];
 static uint8_t g_num_triggers = 0;
 static bool g_triggers_probed = false;
+static bool g_watch_filtered = false;
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+#define RISCV_SW_BKPT_MAX   16u
+
+// Software breakpoint: ebreak/c.ebreak patched over a RAM-resident instruction
+typedef struct {
+    uint32_t addr;
+    uint32_t orig;
+    uint8_t  size;   // 2 = c.ebreak, 4 = ebreak
+    bool     used;
+} riscv_sw_bkpt_t;
+
+static riscv_sw_bkpt_t g_sw_bkpts[RISCV_SW_BKPT_MAX];
+#endif
 
 static bool g_dm_active = false;
+static bool g_impebreak = false;
 static uint8_t g_progbuf_size = 0;
 static uint8_t g_data_count = 0;
 static bool g_has_sba = false;  // System Bus Access
@@ -194,6 +252,16 @@ static bool riscv_write_csr(uint32_t csr, uint32_t val)
     return dm_exec_abstract(cmd, NULL);
 }
 
+// Check whether this trigger keeps a given tdata1 value (fields are WARL).
+static bool riscv_trigger_accepts(uint32_t cfg, uint32_t mask)
+{
+    uint32_t rb;
+    if (!riscv_write_csr(CSR_TDATA1, cfg)) return false;
+    bool ok = riscv_read_csr(CSR_TDATA1, &rb) && ((rb & mask) == (cfg & mask));
+    (void)riscv_write_csr(CSR_TDATA1, 0);
+    return ok;
+}
+
 // Probe available triggers
 static bool riscv_triggers_init(void)
 {
@@ -204,6 +272,7 @@ static bool riscv_triggers_init(void)
     // Clear all slots
     for (uint8_t i = 0; i < RISCV_MAX_TRIGGERS; i++) {
         g_triggers[i].used = false;
+        g_triggers[i].caps = 0;
     }
 
     // Probe triggers by writing to tselect
@@ -220,6 +289,27 @@ static bool riscv_triggers_init(void)
         if (type == 0) break;  // No trigger at this index
 
         g_num_triggers = i + 1;
+
+        // tinfo is optional; when present it must list mcontrol for match probing.
+        uint32_t tinfo;
+        if (riscv_read_csr(CSR_TINFO, &tinfo) && tinfo != 1u && !(tinfo & TINFO_MCONTROL)) {
+            continue;
+        }
+
+        uint32_t base = MCONTROL_TYPE_MCONTROL | MCONTROL_DMODE | MCONTROL_M | MCONTROL_U | MCONTROL_LOAD;
+        if (riscv_trigger_accepts(base | MCONTROL_MATCH(MATCH_NAPOT), MCONTROL_MATCH_MASK)) {
+            g_triggers[i].caps |= TRIG_CAP_NAPOT;
+        }
+        if (riscv_trigger_accepts(base | MCONTROL_MATCH(MATCH_GE), MCONTROL_MATCH_MASK) &&
+            riscv_trigger_accepts(base | MCONTROL_MATCH(MATCH_LT), MCONTROL_MATCH_MASK)) {
+            g_triggers[i].caps |= TRIG_CAP_RANGE;
+        }
+        if (riscv_trigger_accepts(base | MCONTROL_CHAIN, MCONTROL_CHAIN)) {
+            g_triggers[i].caps |= TRIG_CAP_CHAIN;
+        }
+        if (riscv_trigger_accepts(base | MCONTROL_SELECT, MCONTROL_SELECT)) {
+            g_triggers[i].caps |= TRIG_CAP_DATA;
+        }
     }
 
     return g_num_triggers > 0;
@@ -271,6 +361,7 @@ bool riscv_init(void)
         return false;
     }
 
+    g_impebreak = (dmstatus & DMSTATUS_IMPEBREAK) != 0;
     g_data_count = acs & ABSTRACTCS_DATACOUNT_MASK;
     g_progbuf_size = (acs & ABSTRACTCS_PROGBUFSIZE_MASK) >> ABSTRACTCS_PROGBUFSIZE_SHIFT;
 
@@ -312,10 +403,19 @@ bool riscv_halt(void)
     return false;
 }
 
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+static bool riscv_enable_ebreak_debug(void);
+#endif
+
 bool riscv_continue(void)
 {
     if (!g_dm_active) return false;
 
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+    // Semihosting traps are ebreaks; they have to reach the probe, not mtvec.
+    (void)riscv_enable_ebreak_debug();
+#endif
+
     // Request resume
     if (!jtag_dmi_write(DM_DMCONTROL, DMCONTROL_DMACTIVE | DMCONTROL_RESUMEREQ)) {
         return false;
@@ -631,11 +731,165 @@ uint8_t riscv_stop_reason(void)
     }
 }
 
-// Breakpoint support via trigger module
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+// Make patched instructions visible to instruction fetch. SBA writes bypass
+// the hart, so run fence.i from the Program Buffer when there is one.
+static bool riscv_fence_i(void)
+{
+    if (g_progbuf_size == 0) return true;
+    if (g_progbuf_size < 2 && !g_impebreak) return true;
+
+    if (!jtag_dmi_write(DM_PROGBUF0, RV_FENCE_I)) return false;
+    if (g_progbuf_size >= 2) {
+        if (!jtag_dmi_write(DM_PROGBUF1, RV_EBREAK)) return false;
+    }
+    uint32_t cmd = (AC_ACCESS_REGISTER << 24) | AC_AR_AARSIZE_32 | AC_AR_POSTEXEC;
+    return dm_exec_abstract(cmd, NULL);
+}
+
+#endif
+
+#if (defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)) || \
+    (defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING))
+// ebreak in M/U mode must enter Debug Mode instead of raising an exception.
+static bool riscv_enable_ebreak_debug(void)
+{
+    uint32_t dcsr;
+    if (!riscv_read_csr(REG_DCSR, &dcsr)) return false;
+    if ((dcsr & (DCSR_EBREAKM | DCSR_EBREAKU)) == (DCSR_EBREAKM | DCSR_EBREAKU)) return true;
+    return riscv_write_csr(REG_DCSR, dcsr | DCSR_EBREAKM | DCSR_EBREAKU);
+}
+#endif
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+
+static riscv_sw_bkpt_t *sw_bkpt_find(uint32_t addr)
+{
+    for (uint8_t i = 0; i < RISCV_SW_BKPT_MAX; i++) {
+        if (g_sw_bkpts[i].used && g_sw_bkpts[i].addr == addr) {
+            return &g_sw_bkpts[i];
+        }
+    }
+    return NULL;
+}
+
+static bool sw_bkpt_insert(uint32_t addr)
+{
+    if (sw_bkpt_find(addr)) return true;
+
+    riscv_sw_bkpt_t *bp = NULL;
+    for (uint8_t i = 0; i < RISCV_SW_BKPT_MAX; i++) {
+        if (!g_sw_bkpts[i].used) {
+            bp = &g_sw_bkpts[i];
+            break;
+        }
+    }
+    if (!bp) return false;
+
+    // Low two bits of the first halfword select the instruction length.
+    uint8_t orig[4] = {0, 0, 0, 0};
+    if (!riscv_mem_read(addr, orig, 2)) return false;
+    uint8_t size = ((orig[0] & 3u) == 3u) ? 4u : 2u;
+    if (size == 4u && !riscv_mem_read(addr + 2u, &orig[2], 2)) return false;
+
+    uint32_t insn = (size == 4u) ? RV_EBREAK : RV_C_EBREAK;
+    uint8_t patch[4] = {(uint8_t)insn, (uint8_t)(insn >> 8), (uint8_t)(insn >> 16), (uint8_t)(insn >> 24)};
+    if (!riscv_mem_write(addr, patch, size)) return false;
+
+    // Read back: ROM/flash ignores the write and must not be claimed.
+    uint8_t check[4];
+    if (!riscv_mem_read(addr, check, size)) return false;
+    for (uint8_t i = 0; i < size; i++) {
+        if (check[i] != patch[i]) {
+            (void)riscv_mem_write(addr, orig, size);
+            return false;
+        }
+    }
+
+    if (!riscv_enable_ebreak_debug() || !riscv_fence_i()) {
+        (void)riscv_mem_write(addr, orig, size);
+        return false;
+    }
+
+    bp->addr = addr;
+    bp->orig = (uint32_t)orig[0] | ((uint32_t)orig[1] << 8) |
+               ((uint32_t)orig[2] << 16) | ((uint32_t)orig[3] << 24);
+    bp->size = size;
+    bp->used = true;
+    return true;
+}
+
+static bool sw_bkpt_remove(riscv_sw_bkpt_t *bp)
+{
+    uint8_t orig[4] = {(uint8_t)bp->orig, (uint8_t)(bp->orig >> 8),
+                       (uint8_t)(bp->orig >> 16), (uint8_t)(bp->orig >> 24)};
+    if (!riscv_mem_write(bp->addr, orig, bp->size)) return false;
+    bp->used = false;
+    return riscv_fence_i();
+}
+#endif
+
+void riscv_sw_breakpoints_mask_read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    for (uint8_t i = 0; i < RISCV_SW_BKPT_MAX; i++) {
+        if (!g_sw_bkpts[i].used) continue;
+        for (uint32_t b = 0; b < g_sw_bkpts[i].size; b++) {
+            uint32_t a = g_sw_bkpts[i].addr + b;
+            if (a - addr < len) {
+                buf[a - addr] = (uint8_t)(g_sw_bkpts[i].orig >> (8u * b));
+            }
+        }
+    }
+#else
+    (void)addr; (void)buf; (void)len;
+#endif
+}
+
+void riscv_sw_breakpoints_after_write(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    bool patched = false;
+    for (uint8_t i = 0; i < RISCV_SW_BKPT_MAX; i++) {
+        riscv_sw_bkpt_t *bp = &g_sw_bkpts[i];
+        if (!bp->used) continue;
+
+        bool hit = false;
+        for (uint32_t b = 0; b < bp->size; b++) {
+            uint32_t a = bp->addr + b;
+            if (a - addr < len) {
+                uint32_t mask = 0xFFu << (8u * b);
+                bp->orig = (bp->orig & ~mask) | ((uint32_t)buf[a - addr] << (8u * b));
+                hit = true;
+            }
+        }
+        if (hit) {
+            // Keep the breakpoint armed; the written bytes become the saved instruction.
+            uint32_t insn = (bp->size == 4u) ? RV_EBREAK : RV_C_EBREAK;
+            uint8_t patch[4] = {(uint8_t)insn, (uint8_t)(insn >> 8), (uint8_t)(insn >> 16), (uint8_t)(insn >> 24)};
+            (void)riscv_mem_write(bp->addr, patch, bp->size);
+            patched = true;
+        }
+    }
+    if (patched) {
+        (void)riscv_fence_i();
+    }
+#else
+    (void)addr; (void)buf; (void)len;
+#endif
+}
+
+// Breakpoint support via trigger module, with ebreak patching as fallback
 bool riscv_breakpoint_insert(uint32_t addr)
 {
     if (!g_dm_active) return false;
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    if (sw_bkpt_find(addr)) return true;
+    if (!riscv_triggers_init()) return sw_bkpt_insert(addr);
+#else
     if (!riscv_triggers_init()) return false;
+#endif
 
     // Check if already installed
     for (uint8_t i = 0; i < g_num_triggers; i++) {
@@ -664,13 +918,24 @@ bool riscv_breakpoint_insert(uint32_t addr)
             return true;
         }
     }
+
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    // Triggers exhausted: patch an ebreak if the code is in RAM
+    return sw_bkpt_insert(addr);
+#else
     return false;  // No free slots
+#endif
 }
 
 bool riscv_breakpoint_remove(uint32_t addr)
 {
     if (!g_dm_active) return true;
 
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    riscv_sw_bkpt_t *bp = sw_bkpt_find(addr);
+    if (bp) return sw_bkpt_remove(bp);
+#endif
+
     for (uint8_t i = 0; i < g_num_triggers; i++) {
         if (g_triggers[i].used && g_triggers[i].type == 1 &&
             g_triggers[i].addr == addr) {
@@ -683,6 +948,17 @@ bool riscv_breakpoint_remove(uint32_t addr)
     return true;  // Safe to remove non-existent
 }
 
+bool riscv_breakpoint_at(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_SW_BREAKPOINTS) && (PROBE_ENABLE_SW_BREAKPOINTS)
+    if (sw_bkpt_find(addr)) return true;
+#endif
+    for (uint8_t i = 0; i < g_num_triggers; i++) {
+        if (g_triggers[i].used && g_triggers[i].type == 1 && g_triggers[i].addr == addr) return true;
+    }
+    return false;
+}
+
 // Watchpoint support via trigger module
 bool riscv_watchpoints_supported(void)
 {
@@ -690,78 +966,291 @@ bool riscv_watchpoints_supported(void)
     return riscv_triggers_init() && g_num_triggers > 0;
 }
 
+static int riscv_watch_find(target_watch_t type, uint32_t addr, uint32_t len)
+{
+    for (uint8_t i = 0; i < g_num_triggers; i++) {
+        if (g_triggers[i].used && g_triggers[i].type == 2 && g_triggers[i].addr == addr &&
+            g_triggers[i].len == len && g_triggers[i].watch == (uint8_t)type) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool riscv_trigger_program(uint8_t i, uint32_t tdata2, uint32_t cfg)
+{
+    if (!riscv_write_csr(CSR_TSELECT, i)) return false;
+    if (!riscv_write_csr(CSR_TDATA1, 0)) return false;
+    if (!riscv_write_csr(CSR_TDATA2, tdata2)) return false;
+    return riscv_write_csr(CSR_TDATA1, cfg);
+}
+
+static void riscv_trigger_disable(uint8_t i)
+{
+    riscv_write_csr(CSR_TSELECT, i);
+    riscv_write_csr(CSR_TDATA1, 0);
+    g_triggers[i].used = false;
+    g_triggers[i].type = 0;
+    g_triggers[i].has_value = false;
+}
+
 bool riscv_watchpoint_insert(target_watch_t type, uint32_t addr, uint32_t len)
 {
-    (void)len;  // RISC-V triggers don't support length directly
     if (!g_dm_active) return false;
     if (!riscv_triggers_init()) return false;
+    if (len == 0) len = 1;
+
+    if (riscv_watch_find(type, addr, len) >= 0) return true;
+
+    uint32_t cfg = MCONTROL_TYPE_MCONTROL | MCONTROL_DMODE |
+                   MCONTROL_ACTION_DEBUG | MCONTROL_M | MCONTROL_U;
+    if (type == TARGET_WATCH_WRITE) {
+        cfg |= MCONTROL_STORE;
+    } else if (type == TARGET_WATCH_READ) {
+        cfg |= MCONTROL_LOAD;
+    } else {  // ACCESS
+        cfg |= MCONTROL_LOAD | MCONTROL_STORE;
+    }
 
-    // Find free slot
-    for (uint8_t i = 0; i < g_num_triggers; i++) {
-        if (!g_triggers[i].used) {
-            if (!riscv_write_csr(CSR_TSELECT, i)) return false;
-            if (!riscv_write_csr(CSR_TDATA1, 0)) return false;
-            if (!riscv_write_csr(CSR_TDATA2, addr)) return false;
+    bool pow2_aligned = ((len & (len - 1u)) == 0) && ((addr & (len - 1u)) == 0);
 
-            uint32_t cfg = MCONTROL_TYPE_MCONTROL | MCONTROL_DMODE |
-                           MCONTROL_ACTION_DEBUG | MCONTROL_M | MCONTROL_U;
-
-            if (type == TARGET_WATCH_WRITE) {
-                cfg |= MCONTROL_STORE;
-            } else if (type == TARGET_WATCH_READ) {
-                cfg |= MCONTROL_LOAD;
-            } else {  // ACCESS
-                cfg |= MCONTROL_LOAD | MCONTROL_STORE;
+    uint32_t value = 0;
+    bool has_value = len <= 4u && pow2_aligned && target_watch_value_lookup(addr, &value);
+    if (has_value && len < 4u) {
+        value &= (1u << (8u * len)) - 1u;
+    }
+
+    for (uint8_t i = 0; i < g_num_triggers; i++) {
+        if (g_triggers[i].used) continue;
+        uint8_t caps = g_triggers[i].caps;
+        bool ok = false;
+        bool value_hw = false;
+
+        if (has_value && (caps & TRIG_CAP_CHAIN) && (i + 1u) < g_num_triggers &&
+            !g_triggers[i + 1u].used && (g_triggers[i + 1u].caps & TRIG_CAP_DATA)) {
+            // Chained pair: address match on the head, store/load data == value on the tail.
+            ok = riscv_trigger_program(i + 1u, value, cfg | MCONTROL_SELECT | MCONTROL_MATCH(MATCH_EQUAL)) &&
+                 riscv_trigger_program(i, addr, cfg | MCONTROL_MATCH(MATCH_EQUAL) | MCONTROL_CHAIN);
+            if (!ok) {
+                riscv_trigger_disable(i);
+                riscv_trigger_disable(i + 1u);
+                continue;
             }
+            g_triggers[i + 1u].addr = addr;
+            g_triggers[i + 1u].len = len;
+            g_triggers[i + 1u].type = 3;  // chained tail
+            g_triggers[i + 1u].watch = (uint8_t)type;
+            g_triggers[i + 1u].has_value = false;
+            g_triggers[i + 1u].used = true;
+            value_hw = true;
+        } else if (len == 1) {
+            ok = riscv_trigger_program(i, addr, cfg | MCONTROL_MATCH(MATCH_EQUAL));
+        } else if (pow2_aligned && (caps & TRIG_CAP_NAPOT)) {
+            // NAPOT: trailing ones in tdata2 encode the region size
+            ok = riscv_trigger_program(i, addr | ((len >> 1) - 1u), cfg | MCONTROL_MATCH(MATCH_NAPOT));
+        } else if ((caps & (TRIG_CAP_RANGE | TRIG_CAP_CHAIN)) == (TRIG_CAP_RANGE | TRIG_CAP_CHAIN) &&
+                   (i + 1u) < g_num_triggers && !g_triggers[i + 1u].used &&
+                   (g_triggers[i + 1u].caps & TRIG_CAP_RANGE)) {
+            // Chained pair: fires only when both addr >= start and addr < end match.
+            // Program the tail first so the chain never sees a stale second half.
+            ok = riscv_trigger_program(i + 1u, addr + len, cfg | MCONTROL_MATCH(MATCH_LT)) &&
+                 riscv_trigger_program(i, addr, cfg | MCONTROL_MATCH(MATCH_GE) | MCONTROL_CHAIN);
+            if (!ok) {
+                riscv_trigger_disable(i);
+                riscv_trigger_disable(i + 1u);
+                continue;
+            }
+            g_triggers[i + 1u].addr = addr;
+            g_triggers[i + 1u].len = len;
+            g_triggers[i + 1u].type = 3;  // chained tail
+            g_triggers[i + 1u].watch = (uint8_t)type;
+            g_triggers[i + 1u].used = true;
+        } else if (len <= 4u && pow2_aligned) {
+            // No NAPOT/range support: exact match on the base address only
+            // catches accesses that start there (full-width accesses).
+            ok = riscv_trigger_program(i, addr, cfg | MCONTROL_MATCH(MATCH_EQUAL));
+        } else {
+            continue;
+        }
 
-            if (!riscv_write_csr(CSR_TDATA1, cfg)) return false;
+        if (!ok) return false;
 
-            g_triggers[i].addr = addr;
-            g_triggers[i].type = 2;  // watchpoint
-            g_triggers[i].watch = (uint8_t)type;
-            g_triggers[i].used = true;
-            return true;
-        }
+        g_triggers[i].addr = addr;
+        g_triggers[i].len = len;
+        g_triggers[i].type = 2;  // watchpoint
+        g_triggers[i].watch = (uint8_t)type;
+        g_triggers[i].value = value;
+        g_triggers[i].has_value = has_value;
+        g_triggers[i].value_hw = value_hw;
+        g_triggers[i].used = true;
+        return true;
     }
-    return false;  // No free slots
+    return false;  // No free slots (or no trigger can express this range)
 }
 
 bool riscv_watchpoint_remove(target_watch_t type, uint32_t addr, uint32_t len)
 {
-    (void)len;
     if (!g_dm_active) return true;
+    if (len == 0) len = 1;
+
+    int i = riscv_watch_find(type, addr, len);
+    if (i < 0) return true;  // Safe to remove non-existent
+
+    riscv_trigger_disable((uint8_t)i);
+    if ((uint8_t)(i + 1) < g_num_triggers && g_triggers[i + 1].used && g_triggers[i + 1].type == 3) {
+        riscv_trigger_disable((uint8_t)(i + 1));
+    }
+    return true;
+}
+
+// Probe-side value check for watches without a chained data trigger.
+static bool riscv_watch_value_matches(const riscv_trigger_t *t)
+{
+    uint8_t buf[4];
+    if (!riscv_mem_read(t->addr, buf, t->len)) return true;  // can't tell; report the hit
+    for (uint32_t i = 0; i < t->len; i++) {
+        if (buf[i] != (uint8_t)(t->value >> (8u * i))) return false;
+    }
+    return true;
+}
+
+// mcontrol triggers fire before the access (timing=0), so the watched bytes still hold the old
+// value. Step the trapping instruction with the watch triggers masked (M/U cleared), then restore
+// them: the store has retired for the value check, and a silent resume doesn't re-fire on it.
+static bool riscv_watch_step_over(void)
+{
+    uint32_t saved[RISCV_MAX_TRIGGERS];
+    uint8_t masked = 0;
 
     for (uint8_t i = 0; i < g_num_triggers; i++) {
-        if (g_triggers[i].used && g_triggers[i].type == 2 &&
-            g_triggers[i].addr == addr && g_triggers[i].watch == (uint8_t)type) {
-            riscv_write_csr(CSR_TSELECT, i);
-            riscv_write_csr(CSR_TDATA1, 0);
-            g_triggers[i].used = false;
-            return true;
+        if (!g_triggers[i].used || (g_triggers[i].type != 2 && g_triggers[i].type != 3)) continue;
+        if (!riscv_write_csr(CSR_TSELECT, i) || !riscv_read_csr(CSR_TDATA1, &saved[i])) continue;
+        if (riscv_write_csr(CSR_TDATA1, saved[i] & ~(MCONTROL_M | MCONTROL_U | MCONTROL_HIT))) {
+            masked |= (uint8_t)(1u << i);
         }
     }
-    return true;  // Safe to remove non-existent
+
+    bool ok = riscv_step();
+
+    for (uint8_t i = 0; i < g_num_triggers; i++) {
+        if (!(masked & (1u << i))) continue;
+        if (!riscv_write_csr(CSR_TSELECT, i) ||
+            !riscv_write_csr(CSR_TDATA1, saved[i] & ~MCONTROL_HIT)) {
+            ok = false;
+        }
+    }
+    return ok;
 }
 
 bool riscv_watchpoint_hit(target_watch_t *out_type, uint32_t *out_addr)
 {
+    g_watch_filtered = false;
     if (!g_dm_active) return false;
 
+    // Visit every watch trigger so both halves of a chained pair get their hit bit cleared.
+    uint8_t hits = 0;  // bit i: trigger i (a head) fired, in slot order
+    bool check_value = false;
     for (uint8_t i = 0; i < g_num_triggers; i++) {
-        if (g_triggers[i].used && g_triggers[i].type == 2) {
+        if (g_triggers[i].used && (g_triggers[i].type == 2 || g_triggers[i].type == 3)) {
             if (!riscv_write_csr(CSR_TSELECT, i)) continue;
 
             uint32_t tdata1;
             if (riscv_read_csr(CSR_TDATA1, &tdata1) && (tdata1 & MCONTROL_HIT)) {
-                if (out_type) *out_type = (target_watch_t)g_triggers[i].watch;
-                if (out_addr) *out_addr = g_triggers[i].addr;
                 // Clear hit bit by writing back without it
                 riscv_write_csr(CSR_TDATA1, tdata1 & ~MCONTROL_HIT);
-                return true;
+
+                // Chained tail reports as its head (same addr/watch are stored on both)
+                uint8_t h = (g_triggers[i].type == 3 && i > 0) ? (uint8_t)(i - 1u) : i;
+                hits |= (uint8_t)(1u << h);
+                if (g_triggers[h].has_value && !g_triggers[h].value_hw) check_value = true;
             }
         }
     }
+    if (!hits) return false;
+
+    // Compare after the access has retired. If the step fails, report the hit rather than
+    // resuming onto the same instruction.
+    bool stepped = check_value && riscv_watch_step_over();
+
+    bool filtered = false;
+    for (uint8_t i = 0; i < g_num_triggers; i++) {
+        if (!(hits & (1u << i))) continue;
+        const riscv_trigger_t *t = &g_triggers[i];
+        if (stepped && t->has_value && !t->value_hw && !riscv_watch_value_matches(t)) {
+            filtered = true;
+            continue;
+        }
+        if (out_type) *out_type = (target_watch_t)t->watch;
+        if (out_addr) *out_addr = t->addr;
+        return true;
+    }
+    g_watch_filtered = filtered;
     return false;
 }
 
+bool riscv_watchpoint_filtered(void)
+{
+    return g_watch_filtered;
+}
+
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+// No PC sampling register in the Debug Module: halt, read dpc, resume. If the hart
+// stopped for another reason (dcsr.cause != haltreq), leave it halted.
+bool riscv_sample_pc(uint32_t *out)
+{
+    bool halted;
+    if (!riscv_is_halted(&halted) || halted) return false;
+    if (!riscv_halt()) return false;
+
+    uint32_t dcsr;
+    if (!riscv_read_csr(REG_DCSR, &dcsr)) return false;
+    if (((dcsr & DCSR_CAUSE_MASK) >> DCSR_CAUSE_SHIFT) != DCSR_CAUSE_HALTREQ) return false;
+
+    bool ok = riscv_read_csr(REG_DPC, out);
+    (void)riscv_continue();
+    return ok;
+}
+#endif
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+// mcycle (low 32 bits). dcsr.stopcount is set where implemented so debug-mode
+// time (halts, steps) isn't counted.
+bool riscv_cycle_count(uint32_t *out)
+{
+    uint32_t dcsr;
+    if (riscv_read_csr(REG_DCSR, &dcsr) && !(dcsr & DCSR_STOPCOUNT)) {
+        (void)riscv_write_csr(REG_DCSR, dcsr | DCSR_STOPCOUNT);
+    }
+    return riscv_read_csr(CSR_MCYCLE, out);
+}
+#endif
+
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+// Semihosting trap: the uncompressed sequence slli x0,x0,0x1f / ebreak / srai x0,x0,7
+// with dpc on the ebreak. op = a0, arg = a1.
+#define RV_SEMIHOST_ENTRY 0x01F01013u
+#define RV_SEMIHOST_EXIT  0x40705013u
+
+bool riscv_semihost_pending(uint32_t *out_op, uint32_t *out_arg)
+{
+    uint32_t dcsr, dpc;
+    uint8_t  b[12];
+    uint32_t w[3];
+    if (!riscv_read_csr(REG_DCSR, &dcsr) || ((dcsr & DCSR_CAUSE_MASK) >> DCSR_CAUSE_SHIFT) != 1u) return false;
+    if (!riscv_read_csr(REG_DPC, &dpc) || !riscv_mem_read(dpc - 4u, b, sizeof(b))) return false;
+    for (uint32_t i = 0; i < 3u; i++) {
+        w[i] = (uint32_t)b[4u * i] | ((uint32_t)b[4u * i + 1u] << 8) | ((uint32_t)b[4u * i + 2u] << 16) |
+               ((uint32_t)b[4u * i + 3u] << 24);
+    }
+    if (w[0] != RV_SEMIHOST_ENTRY || w[1] != RV_EBREAK || w[2] != RV_SEMIHOST_EXIT) return false;
+    return riscv_read_reg(10, out_op) && riscv_read_reg(11, out_arg);
+}
+
+bool riscv_semihost_return(uint32_t result)
+{
+    uint32_t dpc;
+    return riscv_write_reg(10, result) && riscv_read_csr(REG_DPC, &dpc) && riscv_write_csr(REG_DPC, dpc + 4u);
+}
+#endif
+
 #endif // PROBE_ENABLE_RISCV
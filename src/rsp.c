@@ -10,6 +10,75 @@
 #include "target.h"
 #include "hal.h"
 
+#if defined(PROBE_ENABLE_MONITOR) && (PROBE_ENABLE_MONITOR)
+#include "monitor.h"
+#endif
+
+#if defined(PROBE_ENABLE_SW_WATCHPOINTS) && (PROBE_ENABLE_SW_WATCHPOINTS)
+#include "swwatch.h"
+#endif
+
+#if defined(PROBE_ENABLE_POLL_WATCH) && (PROBE_ENABLE_POLL_WATCH)
+#include "pollwatch.h"
+#endif
+
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+#include "profile.h"
+#endif
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+#include "regiontime.h"
+#endif
+
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+#include "perfcnt.h"
+#endif
+
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+#include "mtb.h"
+#endif
+
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+#include "coverage.h"
+#endif
+
+#if defined(PROBE_ENABLE_RTT) && (PROBE_ENABLE_RTT)
+#include "rtt.h"
+#endif
+
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+#include "semihost.h"
+#endif
+
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+#include "swo.h"
+#endif
+
+#if defined(PROBE_ENABLE_LIVE_WATCH) && (PROBE_ENABLE_LIVE_WATCH)
+#include "live.h"
+#endif
+
+#if (defined(PROBE_ENABLE_COMPRESSED_READ) && (PROBE_ENABLE_COMPRESSED_READ)) || \
+    (defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE))
+#include "lz.h"
+#endif
+
+#if defined(PROBE_ENABLE_DELTA_READ) && (PROBE_ENABLE_DELTA_READ)
+#include "delta.h"
+#endif
+
+#if defined(PROBE_ENABLE_QCRC) && (PROBE_ENABLE_QCRC)
+#include "crc32.h"
+#endif
+
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+#include "cortex.h"
+#endif
+
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+#include "flash.h"
+#endif
+
 #ifndef PROBE_TINY_RAM
 #define PROBE_TINY_RAM 0
 #endif
@@ -173,6 +242,22 @@ static void rsp_send_packet_prefix_and_bytes(char prefix, const char *payload, u
     rsp_send_packet_end(sum);
 }
 
+#if (defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE)) || \
+    (defined(PROBE_ENABLE_DELTA_READ) && (PROBE_ENABLE_DELTA_READ)) || (defined(PROBE_ENABLE_QSEARCH) && (PROBE_ENABLE_QSEARCH))
+// Minimal-width lowercase hex, no terminator. Returns the number of digits written.
+static uint32_t rsp_format_hex_u32(char *out, uint32_t v)
+{
+    uint32_t k = 0;
+    for (int32_t shift = 28; shift >= 0; shift -= 4) {
+        uint8_t nib = (uint8_t) (v >> shift) & 0xFu;
+        if (nib || k || shift == 0) {
+            out[k++] = nibble_hex(nib);
+        }
+    }
+    return k;
+}
+#endif
+
 static void rsp_send_ok(void) { rsp_send_packet_str("OK"); }
 static void rsp_send_err(void) { rsp_send_packet_str("E01"); }
 static void rsp_send_empty(void) { rsp_send_packet_str(""); }
@@ -297,17 +382,172 @@ static bool rsp_parse_regs_hex(const char *hex, uint32_t regs[17])
     return true;
 }
 
-static void handle_qSupported(void)
+void rsp_console_write_bytes(const uint8_t *buf, uint32_t len)
+{
+    uint8_t sum;
+    rsp_send_packet_begin(&sum);
+    sum = (uint8_t) (sum + (uint8_t) 'O');
+    uart_putc('O');
+    while (len--) {
+        uint8_t b  = *buf++;
+        char    h1 = nibble_hex(b >> 4);
+        char    h2 = nibble_hex(b);
+        sum        = (uint8_t) (sum + (uint8_t) h1);
+        uart_putc((uint8_t) h1);
+        sum = (uint8_t) (sum + (uint8_t) h2);
+        uart_putc((uint8_t) h2);
+    }
+    rsp_send_packet_end(sum);
+}
+
+void rsp_console_write(const char *s) { rsp_console_write_bytes((const uint8_t *) s, (uint32_t) strlen(s)); }
+
+#if (defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)) || \
+    (defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO))
+void rsp_console_flush(rsp_console_line_t *con)
 {
+    if (con->len) {
+        rsp_console_write_bytes(con->buf, con->len);
+        con->len = 0;
+    }
+}
+
+void rsp_console_putc(rsp_console_line_t *con, uint8_t c)
+{
+    con->buf[con->len++] = c;
+    con->last_us         = hal_time_us();
+    if (c == '\n' || con->len == RSP_CON_SIZE) {
+        rsp_console_flush(con);
+    }
+}
+
+void rsp_console_poll(rsp_console_line_t *con, bool force)
+{
+    if (con->len && (force || (hal_time_us() - con->last_us) >= RSP_CON_IDLE_US)) {
+        rsp_console_flush(con);
+    }
+}
+#endif
+
+#if defined(PROBE_ENABLE_MONITOR) && (PROBE_ENABLE_MONITOR)
+static void handle_qRcmd(const char *p)
+{
+    // qRcmd,<hex command>: decode in place at the start of rsp_buf (output is shorter).
+    const char *hex = p + (sizeof("qRcmd,") - 1u);
+    uint32_t    n   = (uint32_t) strlen(hex) / 2u;
+    if (!rsp_hex_to_bytes(hex, (uint8_t *) rsp_buf, n)) {
+        rsp_send_err();
+        return;
+    }
+    rsp_buf[n] = '\0';
+
+    if (monitor_command(rsp_buf)) {
+        rsp_send_ok();
+    } else {
+        rsp_send_err();
+    }
+}
+#endif
+
 #if defined(PROBE_ENABLE_QXFER_TARGET_XML) && (PROBE_ENABLE_QXFER_TARGET_XML)
-    rsp_send_packet_str("PacketSize=" RSP_PACKET_SIZE_HEX ";swbreak+;hwbreak+;qXfer:features:read+");
+#define RSP_FEATURE_TARGET_XML ";qXfer:features:read+"
+#else
+#define RSP_FEATURE_TARGET_XML ""
+#endif
+
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+#define RSP_FEATURE_BTRACE ";Qbtrace:bts+;Qbtrace:off+;qXfer:btrace:read+;qXfer:btrace-conf:read+"
+#else
+#define RSP_FEATURE_BTRACE ""
+#endif
+
+#if defined(PROBE_ENABLE_MEM_VECTOR) && (PROBE_ENABLE_MEM_VECTOR)
+#define RSP_FEATURE_MEM_VECTOR ";qProbe.ReadV+;QProbe.WriteV+"
+#else
+#define RSP_FEATURE_MEM_VECTOR ""
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_READ) && (PROBE_ENABLE_COMPRESSED_READ)
+#define RSP_FEATURE_MEMZ_READ ";qXfer:probe-memz:read+"
+#else
+#define RSP_FEATURE_MEMZ_READ ""
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE)
+#define RSP_FEATURE_MEMZ_WRITE ";QProbe.WriteZ+"
 #else
-    rsp_send_packet_str("PacketSize=" RSP_PACKET_SIZE_HEX ";swbreak+;hwbreak+");
+#define RSP_FEATURE_MEMZ_WRITE ""
 #endif
+
+#if defined(PROBE_ENABLE_DELTA_READ) && (PROBE_ENABLE_DELTA_READ)
+#define RSP_FEATURE_DELTA ";qProbe.Delta+"
+#else
+#define RSP_FEATURE_DELTA ""
+#endif
+
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+#define RSP_FEATURE_MEMORY_MAP ";qXfer:memory-map:read+"
+#else
+#define RSP_FEATURE_MEMORY_MAP ""
+#endif
+
+static void handle_qSupported(void)
+{
+    rsp_send_packet_str("PacketSize=" RSP_PACKET_SIZE_HEX ";swbreak+;hwbreak+" RSP_FEATURE_TARGET_XML RSP_FEATURE_BTRACE
+                        RSP_FEATURE_MEM_VECTOR RSP_FEATURE_MEMZ_READ RSP_FEATURE_MEMZ_WRITE RSP_FEATURE_DELTA
+                        RSP_FEATURE_MEMORY_MAP);
 }
 
 static bool rsp_running = false;
 
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+static void rsp_send_exit(uint8_t code)
+{
+    char w[4] = {'W', nibble_hex(code >> 4), nibble_hex(code), '\0'};
+    rsp_send_packet_str(w);
+}
+
+// Act on a semihosting status: resume, forward a File-I/O request, or report a stop.
+static void rsp_semihost_next(semihost_status_t st)
+{
+    if (st == SEMIHOST_RESUME && target_continue()) {
+        rsp_running = true;
+    } else if (st == SEMIHOST_FILEIO) {
+        rsp_send_packet_str(semihost_request());
+    } else if (st == SEMIHOST_EXIT) {
+        rsp_send_exit(semihost_exit_code());
+    } else {
+        rsp_send_sigtrap();
+    }
+}
+
+static void handle_fileio_reply(const char *p)
+{
+    // Fretcode[,errno][,C]: retcode may be negative.
+    bool        neg = (p[1] == '-');
+    uint32_t    ret = 0, err = 0;
+    const char *q   = p + (neg ? 2 : 1);
+    while (hex_nibble(*q) != 0xFF) {
+        ret = (ret << 4) | hex_nibble(*q++);
+    }
+    if (*q == ',' && q[1] != 'C') {
+        q++;
+        while (hex_nibble(*q) != 0xFF) {
+            err = (err << 4) | hex_nibble(*q++);
+        }
+    }
+    bool ctrl_c = (strstr(q, ",C") != NULL);
+
+    semihost_status_t st = semihost_on_reply(neg ? -(int32_t) ret : (int32_t) ret, err);
+    if (ctrl_c && st == SEMIHOST_RESUME) {
+        // The call completed, but the user pressed Ctrl-C meanwhile: stop here.
+        rsp_send_packet_str("S02");
+        return;
+    }
+    rsp_semihost_next(st);
+}
+#endif
+
 static bool parse_u32_le_hex_bytes(const char *hex, uint32_t *out)
 {
     uint32_t v = 0;
@@ -379,12 +619,19 @@ static void handle_breakpoint(const char *p)
             wt = TARGET_WATCH_ACCESS;
         }
 
+#if defined(PROBE_ENABLE_SW_WATCHPOINTS) && (PROBE_ENABLE_SW_WATCHPOINTS)
+        // Hardware first; write watches it can't take are emulated by stepping on the probe.
+        bool hw = target_watchpoints_supported();
+        bool ok = is_set ? ((hw && target_watchpoint_insert(wt, addr, kind)) || swwatch_insert(wt, addr, kind))
+                         : (swwatch_remove(wt, addr, kind) || !hw || target_watchpoint_remove(wt, addr, kind));
+#else
         if (!target_watchpoints_supported()) {
             rsp_send_empty();
             return;
         }
 
         bool ok = is_set ? target_watchpoint_insert(wt, addr, kind) : target_watchpoint_remove(wt, addr, kind);
+#endif
         if (ok) {
             rsp_send_ok();
         } else {
@@ -396,6 +643,558 @@ static void handle_breakpoint(const char *p)
     rsp_send_empty();
 }
 
+#if defined(PROBE_ENABLE_MEM_VECTOR) && (PROBE_ENABLE_MEM_VECTOR)
+#define RSP_MEMV_MAX 16u  // regions per ReadV/WriteV packet
+
+typedef struct {
+    uint32_t addr;
+    uint16_t len;
+    uint16_t off;  // data position in rsp_iobuf
+    uint16_t hex;  // WriteV: data position in rsp_buf
+} rsp_memv_t;
+
+static rsp_memv_t rsp_memv[RSP_MEMV_MAX];
+static uint8_t    rsp_memv_order[RSP_MEMV_MAX];
+
+// Hex digits up to the first non-hex character; at least one is required.
+static bool parse_u32_hex_next(const char *s, uint32_t *out, const char **endp)
+{
+    uint32_t    v = 0;
+    const char *p = s;
+    while (hex_nibble(*p) != 0xFF) {
+        v = (v << 4) | hex_nibble(*p);
+        p++;
+    }
+    if (p == s) {
+        return false;
+    }
+    *out  = v;
+    *endp = p;
+    return true;
+}
+
+// Sort the regions by address and lay them out in rsp_iobuf so that adjacent (and, for
+// reads, overlapping) regions share one span, which is then moved in a single
+// auto-increment burst. Returns false if the data doesn't fit.
+static bool rsp_memv_layout(uint32_t n, bool allow_overlap)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = i;
+        while (j > 0u && rsp_memv[rsp_memv_order[j - 1u]].addr > rsp_memv[i].addr) {
+            rsp_memv_order[j] = rsp_memv_order[j - 1u];
+            j--;
+        }
+        rsp_memv_order[j] = (uint8_t) i;
+    }
+
+    uint32_t span_addr = 0;
+    uint32_t span_end  = 0;
+    uint32_t span_off  = 0;
+    uint32_t used      = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        rsp_memv_t *r = &rsp_memv[rsp_memv_order[k]];
+        if (k == 0u || r->addr > span_end) {
+            span_addr = r->addr;
+            span_end  = r->addr;
+            span_off  = used;
+        } else if (r->addr < span_end && !allow_overlap) {
+            return false;
+        }
+        r->off = (uint16_t) (span_off + (r->addr - span_addr));
+        if (r->addr + r->len > span_end) {
+            span_end = r->addr + r->len;
+            used     = span_off + (span_end - span_addr);
+            if (used > (uint32_t) sizeof(rsp_iobuf)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Calls fn once per merged span, in address order.
+static bool rsp_memv_spans(uint32_t n, bool (*fn)(uint32_t addr, uint8_t *buf, uint32_t len))
+{
+    uint32_t k = 0;
+    while (k < n) {
+        const rsp_memv_t *first = &rsp_memv[rsp_memv_order[k]];
+        uint32_t          end   = first->addr + first->len;
+        for (k++; k < n && rsp_memv[rsp_memv_order[k]].addr <= end; k++) {
+            const rsp_memv_t *r = &rsp_memv[rsp_memv_order[k]];
+            if (r->addr + r->len > end) {
+                end = r->addr + r->len;
+            }
+        }
+        if (!fn(first->addr, &rsp_iobuf[first->off], end - first->addr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool rsp_memv_write_span(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    return target_mem_write_bytes(addr, buf, len);
+}
+
+// addr,len[:hex] entries separated by ';'. Lengths are limited so that no region wraps
+// the address space and the total fits rsp_iobuf.
+static bool rsp_memv_parse(const char *p, bool with_data, uint32_t *out_n)
+{
+    uint32_t n     = 0;
+    uint32_t total = 0;
+    while (*p) {
+        uint32_t addr = 0;
+        uint32_t len  = 0;
+        if (n == RSP_MEMV_MAX || !parse_u32_hex_stop(p, ',', &addr, &p) || !parse_u32_hex_next(p, &len, &p) ||
+            len == 0u || len > (uint32_t) sizeof(rsp_iobuf) - total || addr + len < addr) {
+            return false;
+        }
+        rsp_memv[n].addr = addr;
+        rsp_memv[n].len  = (uint16_t) len;
+        total += len;
+        if (with_data) {
+            if (*p++ != ':') {
+                return false;
+            }
+            rsp_memv[n].hex = (uint16_t) (p - rsp_buf);
+            for (uint32_t i = 0; i < 2u * len; i++) {
+                if (hex_nibble(*p++) == 0xFF) {
+                    return false;
+                }
+            }
+        }
+        n++;
+        if (*p == ';') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+    *out_n = n;
+    return n != 0u;
+}
+
+static void handle_qProbe_ReadV(const char *p)
+{
+    // qProbe.ReadV:addr,len;addr,len;... -> the regions' bytes as hex, concatenated in
+    // request order.
+    uint32_t n = 0;
+    if (!rsp_memv_parse(p + (sizeof("qProbe.ReadV:") - 1u), false, &n) || !rsp_memv_layout(n, true) ||
+        !rsp_memv_spans(n, target_mem_read_bytes)) {
+        rsp_send_err();
+        return;
+    }
+
+    uint8_t sum;
+    rsp_send_packet_begin(&sum);
+    for (uint32_t i = 0; i < n; i++) {
+        const uint8_t *d = &rsp_iobuf[rsp_memv[i].off];
+        for (uint32_t j = 0; j < rsp_memv[i].len; j++) {
+            char h1 = nibble_hex(d[j] >> 4);
+            char h2 = nibble_hex(d[j]);
+            sum     = (uint8_t) (sum + (uint8_t) h1 + (uint8_t) h2);
+            uart_putc((uint8_t) h1);
+            uart_putc((uint8_t) h2);
+        }
+    }
+    rsp_send_packet_end(sum);
+}
+
+static void handle_QProbe_WriteV(const char *p)
+{
+    // QProbe.WriteV:addr,len:hex;addr,len:hex;... Regions may touch but not overlap,
+    // since the order in which overlapping bytes land would be unspecified.
+    uint32_t n = 0;
+    if (!rsp_memv_parse(p + (sizeof("QProbe.WriteV:") - 1u), true, &n) || !rsp_memv_layout(n, false)) {
+        rsp_send_err();
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        (void) rsp_hex_to_bytes(&rsp_buf[rsp_memv[i].hex], &rsp_iobuf[rsp_memv[i].off], rsp_memv[i].len);
+    }
+    if (!rsp_memv_spans(n, rsp_memv_write_span)) {
+        rsp_send_err();
+        return;
+    }
+    rsp_send_ok();
+}
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_READ) && (PROBE_ENABLE_COMPRESSED_READ)
+static void handle_qXfer_memz_read(const char *p)
+{
+    // qXfer:probe-memz:read:ADDR,LEN:OFFSET,LENGTH -> target memory as an lz.h stream.
+    // Offset 0 starts a transfer; later reads must continue exactly where the last
+    // reply ended, since the compressor only keeps a sliding window.
+    uint32_t    addr = 0, len = 0, off = 0, max = 0;
+    const char *q = NULL;
+    if (!parse_u32_hex_stop(p + (sizeof("qXfer:probe-memz:read:") - 1u), ',', &addr, &q) ||
+        !parse_u32_hex_stop(q, ':', &len, &q) || !parse_u32_hex_stop(q, ',', &off, &q) || !parse_u32_hex(q, &max)) {
+        rsp_send_err();
+        return;
+    }
+    if (off == 0u) {
+        lz_read_start(addr, len);
+    } else if (!lz_read_matches(addr, len, off)) {
+        rsp_send_err();
+        return;
+    }
+    if (max > RSP_MAX_PAYLOAD - 1u) {
+        max = RSP_MAX_PAYLOAD - 1u;
+    }
+
+    // Binary reply: '#', '$', '}' and '*' are sent as '}' followed by the byte ^ 0x20.
+    uint32_t n = 0;
+    int      c = 0;
+    while ((c = lz_read_peek()) >= 0) {
+        bool esc = (c == '#' || c == '$' || c == '}' || c == '*');
+        if (n + (esc ? 2u : 1u) > max) {
+            break;
+        }
+        if (esc) {
+            rsp_buf[n++] = '}';
+            c ^= 0x20;
+        }
+        rsp_buf[n++] = (char) c;
+        lz_read_skip();
+    }
+    if (c == -2) {
+        rsp_send_err();
+        return;
+    }
+    rsp_send_packet_prefix_and_bytes((c == -1) ? 'l' : 'm', rsp_buf, n);
+}
+#endif
+
+#if (defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE)) || \
+    (defined(PROBE_ENABLE_QSEARCH) && (PROBE_ENABLE_QSEARCH)) || (defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH))
+// Unescape binary packet data ('}' followed by the byte ^ 0x20) in place, from q to the
+// end of the packet (the data may contain NULs). NULL if the last byte is a lone '}'.
+static uint8_t *rsp_unescape_binary(const char *q, const char *end, uint32_t *out_len)
+{
+    uint8_t *d = (uint8_t *) &rsp_buf[q - rsp_buf];
+    uint32_t n = 0;
+    while (q < end) {
+        uint8_t c = (uint8_t) *q++;
+        if (c == '}') {
+            if (q == end) {
+                return NULL;
+            }
+            c = (uint8_t) (*q++ ^ 0x20);
+        }
+        d[n++] = c;
+    }
+    *out_len = n;
+    return d;
+}
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE)
+static void handle_QProbe_WriteZ(const char *p)
+{
+    // QProbe.WriteZ:ADDR,LEN,OFFSET:<binary lz.h stream> -> bytes written so far (hex).
+    // OFFSET counts compressed bytes: 0 starts a transfer, later packets continue it.
+    // The data is binary with the usual '}' escapes.
+    uint32_t    addr = 0, len = 0, off = 0;
+    const char *q = NULL;
+    if (!parse_u32_hex_stop(p + (sizeof("QProbe.WriteZ:") - 1u), ',', &addr, &q) ||
+        !parse_u32_hex_stop(q, ',', &len, &q) || !parse_u32_hex_stop(q, ':', &off, &q)) {
+        rsp_send_err();
+        return;
+    }
+    if (off == 0u) {
+        lz_write_start(addr, len);
+    } else if (!lz_write_matches(addr, len, off)) {
+        rsp_send_err();
+        return;
+    }
+
+    uint32_t n = 0;
+    uint8_t *d = rsp_unescape_binary(q, rsp_buf + rsp_len, &n);
+    if (!d || !lz_write_feed(d, n)) {
+        rsp_send_err();
+        return;
+    }
+
+    char reply[9];
+    reply[rsp_format_hex_u32(reply, lz_write_done())] = '\0';
+    rsp_send_packet_str(reply);
+}
+#endif
+
+#if defined(PROBE_ENABLE_DELTA_READ) && (PROBE_ENABLE_DELTA_READ)
+static void handle_QProbe_DeltaAdd(const char *p)
+{
+    // QProbe.DeltaAdd:ADDR,LEN -> region id (hex). The first qProbe.Delta returns it all.
+    uint32_t    addr = 0, len = 0, id = 0;
+    const char *q = NULL;
+    if (!parse_u32_hex_stop(p + (sizeof("QProbe.DeltaAdd:") - 1u), ',', &addr, &q) || !parse_u32_hex(q, &len) ||
+        !delta_add(addr, len, &id)) {
+        rsp_send_err();
+        return;
+    }
+    char reply[9];
+    reply[rsp_format_hex_u32(reply, id)] = '\0';
+    rsp_send_packet_str(reply);
+}
+
+static void handle_qProbe_Delta(const char *p)
+{
+    // qProbe.Delta:ID -> 'l' (or 'm' if more changed blocks didn't fit) followed by
+    // OFFSET:HEXDATA records for the changed blocks, separated by ';'.
+    uint32_t id = 0;
+    if (!parse_u32_hex(p + (sizeof("qProbe.Delta:") - 1u), &id)) {
+        rsp_send_err();
+        return;
+    }
+
+    uint32_t n    = 1;
+    uint32_t blk  = 0;
+    bool     more = false;
+    for (;;) {
+        uint32_t len = 0;
+        int      r   = delta_next(id, &blk, rsp_iobuf, &len);
+        if (r < 0) {
+            if (n == 1u) {
+                rsp_send_err();
+                return;
+            }
+            more = true;  // send what was committed; the host asks again
+            break;
+        }
+        if (r == 0) {
+            break;
+        }
+        if (n + 1u + 8u + 1u + 2u * len > RSP_MAX_PAYLOAD) {
+            more = true;
+            break;
+        }
+        if (n > 1u) {
+            rsp_buf[n++] = ';';
+        }
+        n += rsp_format_hex_u32(&rsp_buf[n], blk * DELTA_BLOCK);
+        rsp_buf[n++] = ':';
+        for (uint32_t i = 0; i < len; i++) {
+            rsp_buf[n++] = nibble_hex(rsp_iobuf[i] >> 4);
+            rsp_buf[n++] = nibble_hex(rsp_iobuf[i]);
+        }
+        delta_commit(id, blk);
+        blk++;
+    }
+    rsp_buf[0] = more ? 'm' : 'l';
+    rsp_send_packet_bytes(rsp_buf, n);
+}
+#endif
+
+#if defined(PROBE_ENABLE_QCRC) && (PROBE_ENABLE_QCRC)
+static void handle_qCRC(const char *p)
+{
+    // qCRC:ADDR,LENGTH -> C<crc32>. Computed over block reads so only SWD/SBA time is
+    // spent; GDB uses it for compare-sections and to verify loads.
+    uint32_t    addr = 0, len = 0;
+    const char *q = NULL;
+    if (!parse_u32_hex_stop(p + (sizeof("qCRC:") - 1u), ',', &addr, &q) || !parse_u32_hex(q, &len)) {
+        rsp_send_err();
+        return;
+    }
+    uint32_t crc = CRC32_INIT;
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+    // With a stub window the target's core does the whole range at bus speed.
+    if (cortex_stub_crc32(addr, len, &crc)) {
+        len = 0u;
+    } else if (cortex_stub_faulted()) {
+        rsp_console_write("qCRC: stub faulted on the target (HardFault active), reset the target\n");
+        rsp_send_err();
+        return;
+    }
+#endif
+    while (len) {
+        uint32_t n = (len > (uint32_t) sizeof(rsp_iobuf)) ? (uint32_t) sizeof(rsp_iobuf) : len;
+        if (!target_mem_read_bytes(addr, rsp_iobuf, n)) {
+            rsp_send_err();
+            return;
+        }
+        crc = crc32_update(crc, rsp_iobuf, n);
+        addr += n;
+        len -= n;
+    }
+    char reply[10] = {'C'};
+    for (uint32_t i = 0; i < 8u; i++) {
+        reply[1u + i] = nibble_hex((uint8_t) (crc >> (28u - 4u * i)));
+    }
+    reply[9] = '\0';
+    rsp_send_packet_str(reply);
+}
+#endif
+
+#if defined(PROBE_ENABLE_QSEARCH) && (PROBE_ENABLE_QSEARCH)
+static void rsp_send_search_hit(uint32_t at)
+{
+    char reply[11] = {'1', ','};
+    reply[2u + rsp_format_hex_u32(&reply[2], at)] = '\0';
+    rsp_send_packet_str(reply);
+}
+
+static void handle_qSearch_memory(const char *p)
+{
+    // qSearch:memory:ADDR;LENGTH;PATTERN -> "0" or "1,ADDR" for the first match.
+    // PATTERN is binary with '}' escapes.
+    uint32_t    addr = 0, len = 0;
+    const char *q = NULL;
+    if (!parse_u32_hex_stop(p + (sizeof("qSearch:memory:") - 1u), ';', &addr, &q) ||
+        !parse_u32_hex_stop(q, ';', &len, &q)) {
+        rsp_send_err();
+        return;
+    }
+    uint32_t plen = 0;
+    uint8_t *pat  = rsp_unescape_binary(q, rsp_buf + rsp_len, &plen);
+    if (!pat || plen == 0u || plen > (uint32_t) sizeof(rsp_iobuf)) {
+        rsp_send_err();
+        return;
+    }
+
+#if defined(PROBE_ENABLE_TARGET_STUBS) && (PROBE_ENABLE_TARGET_STUBS)
+    bool     found = false;
+    uint32_t at    = 0;
+    if (cortex_stub_search(addr, len, pat, plen, &found, &at)) {
+        if (found) {
+            rsp_send_search_hit(at);
+        } else {
+            rsp_send_packet_str("0");
+        }
+        return;
+    }
+    if (cortex_stub_faulted()) {
+        rsp_console_write("find: stub faulted on the target (HardFault active), reset the target\n");
+        rsp_send_err();
+        return;
+    }
+#endif
+
+    // Stream the range through rsp_iobuf. The last plen - 1 bytes of each block are
+    // carried over, so matches across block boundaries are found too.
+    uint32_t base = addr;  // target address of rsp_iobuf[0]
+    uint32_t keep = 0;
+    uint32_t left = (plen > len) ? 0u : len;
+    while (left) {
+        uint32_t n = (uint32_t) sizeof(rsp_iobuf) - keep;
+        if (n > left) {
+            n = left;
+        }
+        if (!target_mem_read_bytes(base + keep, &rsp_iobuf[keep], n)) {
+            rsp_send_err();
+            return;
+        }
+        left -= n;
+        uint32_t avail = keep + n;
+        for (uint32_t i = 0; i + plen <= avail; i++) {
+            if (rsp_iobuf[i] == pat[0] && memcmp(&rsp_iobuf[i + 1u], &pat[1], plen - 1u) == 0) {
+                rsp_send_search_hit(base + i);
+                return;
+            }
+        }
+        keep = (avail < plen - 1u) ? avail : plen - 1u;
+        memmove(rsp_iobuf, &rsp_iobuf[avail - keep], keep);
+        base += avail - keep;
+    }
+    rsp_send_packet_str("0");
+}
+#endif
+
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+static void handle_qXfer_memory_map_read(const char *p)
+{
+    // qXfer:memory-map:read::OFFSET,LENGTH. Fails until `monitor flash` is complete, which
+    // GDB takes as "no memory map".
+    uint32_t    off = 0, len = 0;
+    const char *r = NULL;
+    if (!parse_u32_hex_stop(p + (sizeof("qXfer:memory-map:read::") - 1u), ',', &off, &r) || !parse_u32_hex(r, &len)) {
+        rsp_send_err();
+        return;
+    }
+    if (len > (RSP_MAX_PAYLOAD - 1u)) {
+        len = (RSP_MAX_PAYLOAD - 1u);
+    }
+
+    uint32_t n    = 0;
+    bool     more = false;
+    if (!flash_memory_map_read(off, rsp_buf, len, &n, &more)) {
+        rsp_send_err();
+        return;
+    }
+    rsp_send_packet_prefix_and_bytes(more ? 'm' : 'l', rsp_buf, n);
+}
+
+static void handle_vFlash(const char *p)
+{
+    // vFlashErase:ADDR,LENGTH, vFlashWrite:ADDR:<binary> and vFlashDone. Writes return
+    // as soon as their data is staged; a programming error shows up on a later packet.
+    uint32_t    addr = 0, len = 0;
+    const char *q  = NULL;
+    bool        ok = false;
+    if (strncmp(p, "vFlashErase:", (sizeof("vFlashErase:") - 1u)) == 0) {
+        ok = parse_u32_hex_stop(p + (sizeof("vFlashErase:") - 1u), ',', &addr, &q) && parse_u32_hex(q, &len) &&
+             flash_erase(addr, len);
+    } else if (strncmp(p, "vFlashWrite:", (sizeof("vFlashWrite:") - 1u)) == 0) {
+        if (parse_u32_hex_stop(p + (sizeof("vFlashWrite:") - 1u), ':', &addr, &q)) {
+            uint8_t *d = rsp_unescape_binary(q, rsp_buf + rsp_len, &len);
+            ok         = d && flash_write(addr, d, len);
+        }
+    } else if (strcmp(p, "vFlashDone") == 0) {
+        ok = flash_done();
+    } else {
+        rsp_send_empty();
+        return;
+    }
+    if (ok) {
+        rsp_send_ok();
+    } else {
+        rsp_send_err();
+    }
+}
+#endif
+
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+static void handle_qXfer_btrace_read(const char *p, bool conf)
+{
+    // qXfer:btrace:read:{all,new,delta}:OFFSET,LENGTH or qXfer:btrace-conf:read::OFFSET,LENGTH
+    const char *annex = p + (conf ? (sizeof("qXfer:btrace-conf:read:") - 1u) : (sizeof("qXfer:btrace:read:") - 1u));
+    const char *q     = strchr(annex, ':');
+    if (!q) {
+        rsp_send_err();
+        return;
+    }
+    // The MTB only holds a full snapshot: "new" is answered with all of it, "delta"
+    // fails so GDB falls back to re-reading everything.
+    if (!conf && strncmp(annex, "all:", 4) != 0 && strncmp(annex, "new:", 4) != 0) {
+        rsp_send_err();
+        return;
+    }
+
+    uint32_t    off = 0, len = 0;
+    const char *r = NULL;
+    if (!parse_u32_hex_stop(q + 1, ',', &off, &r) || !parse_u32_hex(r, &len)) {
+        rsp_send_err();
+        return;
+    }
+    if (len > (RSP_MAX_PAYLOAD - 1u)) {
+        len = (RSP_MAX_PAYLOAD - 1u);
+    }
+
+    // The request has been parsed, so rsp_buf can hold the reply slice.
+    uint32_t n    = 0;
+    bool     more = false;
+    bool     ok   = conf ? mtb_btrace_conf_read(off, rsp_buf, len, &n, &more)
+                         : mtb_btrace_read(off, rsp_buf, len, &n, &more);
+    if (!ok) {
+        rsp_send_err();
+        return;
+    }
+    rsp_send_packet_prefix_and_bytes(more ? 'm' : 'l', rsp_buf, n);
+}
+#endif
+
 #if defined(PROBE_ENABLE_QXFER_TARGET_XML) && (PROBE_ENABLE_QXFER_TARGET_XML)
 static void handle_qXfer_features_read(const char *p)
 {
@@ -569,6 +1368,17 @@ static void rsp_handle_command(void)
             }
         }
 
+#if defined(PROBE_ENABLE_SW_WATCHPOINTS) && (PROBE_ENABLE_SW_WATCHPOINTS)
+        if (swwatch_active()) {
+            if (!swwatch_start()) {
+                rsp_send_err();
+                return;
+            }
+            rsp_running = true;
+            return;
+        }
+#endif
+
         if (!target_continue()) {
             rsp_send_err();
             return;
@@ -672,6 +1482,103 @@ static void rsp_handle_command(void)
     }
 #endif
 
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+    if (strncmp(p, "qXfer:btrace:read:", (sizeof("qXfer:btrace:read:") - 1u)) == 0) {
+        handle_qXfer_btrace_read(p, false);
+        return;
+    }
+    if (strncmp(p, "qXfer:btrace-conf:read:", (sizeof("qXfer:btrace-conf:read:") - 1u)) == 0) {
+        handle_qXfer_btrace_read(p, true);
+        return;
+    }
+    if (strcmp(p, "Qbtrace:bts") == 0) {
+        if (mtb_enable()) {
+            rsp_send_ok();
+        } else {
+            rsp_send_err();
+        }
+        return;
+    }
+    if (strcmp(p, "Qbtrace:off") == 0) {
+        mtb_disable();
+        rsp_send_ok();
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_READ) && (PROBE_ENABLE_COMPRESSED_READ)
+    if (strncmp(p, "qXfer:probe-memz:read:", (sizeof("qXfer:probe-memz:read:") - 1u)) == 0) {
+        handle_qXfer_memz_read(p);
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_COMPRESSED_WRITE) && (PROBE_ENABLE_COMPRESSED_WRITE)
+    if (strncmp(p, "QProbe.WriteZ:", (sizeof("QProbe.WriteZ:") - 1u)) == 0) {
+        handle_QProbe_WriteZ(p);
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_DELTA_READ) && (PROBE_ENABLE_DELTA_READ)
+    if (strncmp(p, "qProbe.Delta:", (sizeof("qProbe.Delta:") - 1u)) == 0) {
+        handle_qProbe_Delta(p);
+        return;
+    }
+    if (strncmp(p, "QProbe.DeltaAdd:", (sizeof("QProbe.DeltaAdd:") - 1u)) == 0) {
+        handle_QProbe_DeltaAdd(p);
+        return;
+    }
+    if (strcmp(p, "QProbe.DeltaClear") == 0) {
+        delta_clear();
+        rsp_send_ok();
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_MEM_VECTOR) && (PROBE_ENABLE_MEM_VECTOR)
+    if (strncmp(p, "qProbe.ReadV:", (sizeof("qProbe.ReadV:") - 1u)) == 0) {
+        handle_qProbe_ReadV(p);
+        return;
+    }
+    if (strncmp(p, "QProbe.WriteV:", (sizeof("QProbe.WriteV:") - 1u)) == 0) {
+        handle_QProbe_WriteV(p);
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_MONITOR) && (PROBE_ENABLE_MONITOR)
+    if (strncmp(p, "qRcmd,", (sizeof("qRcmd,") - 1u)) == 0) {
+        handle_qRcmd(p);
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_QCRC) && (PROBE_ENABLE_QCRC)
+    if (strncmp(p, "qCRC:", (sizeof("qCRC:") - 1u)) == 0) {
+        handle_qCRC(p);
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_QSEARCH) && (PROBE_ENABLE_QSEARCH)
+    if (strncmp(p, "qSearch:memory:", (sizeof("qSearch:memory:") - 1u)) == 0) {
+        handle_qSearch_memory(p);
+        return;
+    }
+#endif
+
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+    if (strncmp(p, "qXfer:memory-map:read::", (sizeof("qXfer:memory-map:read::") - 1u)) == 0) {
+        handle_qXfer_memory_map_read(p);
+        return;
+    }
+    if (strncmp(p, "vFlash", (sizeof("vFlash") - 1u)) == 0) {
+        handle_vFlash(p);
+        return;
+    }
+#endif
+
     if (strncmp(p, "qSupported", 10) == 0) {
         handle_qSupported();
         return;
@@ -687,8 +1594,27 @@ static void rsp_handle_command(void)
         return;
     }
 
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+    if (p[0] == 'F') {
+        handle_fileio_reply(p);
+        return;
+    }
+#endif
+
     if (p[0] == 'D' || p[0] == 'k') {
         rsp_running = false;
+#if defined(PROBE_ENABLE_SW_WATCHPOINTS) && (PROBE_ENABLE_SW_WATCHPOINTS)
+        swwatch_stop();
+#endif
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+        coverage_stop();
+#endif
+#if defined(PROBE_ENABLE_MTB) && (PROBE_ENABLE_MTB)
+        mtb_disable();  // hand the trace window back to the firmware
+#endif
+#if defined(PROBE_ENABLE_FLASH) && (PROBE_ENABLE_FLASH)
+        flash_abort();
+#endif
         (void) target_continue();
         rsp_send_ok();
         return;
@@ -708,9 +1634,13 @@ void rsp_init(void)
 
 void rsp_process_byte(uint8_t c)
 {
-    // Ctrl-C (0x03) is out-of-band interrupt
-    if (c == 0x03) {
+    // Ctrl-C (0x03) is an out-of-band interrupt. GDB only sends it between packets;
+    // inside one, 0x03 is payload (an escaped '#' in binary data).
+    if (c == 0x03 && rsp_state == RSP_IDLE) {
         rsp_running = false;
+#if defined(PROBE_ENABLE_SW_WATCHPOINTS) && (PROBE_ENABLE_SW_WATCHPOINTS)
+        swwatch_stop();
+#endif
         (void) target_halt();
         rsp_send_sigtrap();
         rsp_state = RSP_IDLE;
@@ -781,18 +1711,106 @@ void rsp_process_byte(uint8_t c)
 void rsp_poll(void)
 {
     if (!rsp_running) {
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+        perfcnt_poll(true);  // stopped in GDB
+#endif
         return;
     }
+#if defined(PROBE_ENABLE_SW_WATCHPOINTS) && (PROBE_ENABLE_SW_WATCHPOINTS)
+    if (swwatch_running()) {
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+        perfcnt_poll(true);  // halted between the probe's single steps
+#endif
+        target_watch_t   wt = TARGET_WATCH_WRITE;
+        uint32_t         wa = 0;
+        swwatch_status_t st = swwatch_run(&wt, &wa);
+        if (st == SWWATCH_RUNNING) {
+            return;
+        }
+        rsp_running = false;
+        if (st == SWWATCH_HIT) {
+            rsp_send_trap_watchpoint(wt, wa);
+        } else {
+            rsp_send_sigtrap();
+        }
+        return;
+    }
+#endif
     bool halted = false;
     if (!target_is_halted(&halted)) {
         return;
     }
+#if defined(PROBE_ENABLE_POLL_WATCH) && (PROBE_ENABLE_POLL_WATCH)
+    uint32_t pa = 0;
+    if (!halted && pollwatch_poll(&pa)) {
+        rsp_running = false;
+        rsp_console_write("pollwatch: condition met\n");
+        rsp_send_trap_watchpoint(TARGET_WATCH_WRITE, pa);
+        return;
+    }
+#endif
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+    if (!halted) {
+        profile_poll();
+    }
+#endif
+#if defined(PROBE_ENABLE_PERF_COUNTERS) && (PROBE_ENABLE_PERF_COUNTERS)
+    perfcnt_poll(halted);
+#endif
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+    if (!halted) {
+        semihost_poll();
+    }
+#endif
+#if defined(PROBE_ENABLE_LIVE_WATCH) && (PROBE_ENABLE_LIVE_WATCH)
+    if (!halted) {
+        live_poll();
+    }
+#endif
+#if defined(PROBE_ENABLE_RTT) && (PROBE_ENABLE_RTT)
+    // On a halt, flush what the target logged last so it shows before the stop reply.
+    rtt_poll(halted);
+#endif
+#if defined(PROBE_ENABLE_SWO) && (PROBE_ENABLE_SWO)
+    swo_poll(halted);
+#endif
     if (halted) {
         rsp_running = false;
+#if defined(PROBE_ENABLE_MTB_COVERAGE) && (PROBE_ENABLE_MTB_COVERAGE)
+        // Every halt drains the trace; watermark halts resume straight away.
+        if (coverage_active() && coverage_on_halt()) {
+            rsp_running = true;
+            return;
+        }
+#endif
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+        semihost_status_t sh = semihost_on_halt();
+        if (sh != SEMIHOST_NOT_MINE) {
+            rsp_semihost_next(sh);
+            return;
+        }
+#endif
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+        if (regiontime_active()) {
+            regiontime_status_t st = regiontime_on_halt();
+            if (st == REGIONTIME_RESUMED) {
+                rsp_running = true;
+                return;
+            }
+            if (st == REGIONTIME_DONE) {
+                rsp_console_write("time: all passes done, see 'monitor time'\n");
+                rsp_send_sigtrap();
+                return;
+            }
+        }
+#endif
         target_watch_t wt = TARGET_WATCH_ACCESS;
         uint32_t        wa = 0;
         if (target_watchpoint_hit(&wt, &wa)) {
             rsp_send_trap_watchpoint(wt, wa);
+        } else if (target_watchpoint_filtered() && target_continue()) {
+            // Only probe-rejected watch hits (masked range, value mismatch): keep running silently.
+            rsp_running = true;
         } else {
             rsp_send_sigtrap();
         }
@@ -0,0 +1,207 @@
+// SEGGER-RTT-compatible target channel (see rtt.h).
+
+#include "rtt.h"
+
+#include "hal.h"
+#include "rsp.h"
+#include "target.h"
+
+// Control block: char acID[16]; int MaxNumUpBuffers; int MaxNumDownBuffers;
+// then the up and down buffer descriptors.
+#define RTT_CB_NUM_UP   16u
+#define RTT_CB_BUFFERS  24u
+#define RTT_DESC_SIZE   24u  // sName, pBuffer, SizeOfBuffer, WrOff, RdOff, Flags
+#define RTT_DESC_BUFFER 4u
+#define RTT_DESC_WROFF  12u
+#define RTT_DESC_RDOFF  16u
+#define RTT_MAX_BUFFERS 16u
+
+#define RTT_MAX_UP        3u       // up-buffers polled
+#define RTT_CHUNK         64u      // bytes per block read / O packet
+#define RTT_POLL_BUDGET   256u     // bytes forwarded per rtt_poll, keeps rsp responsive
+#define RTT_PERIOD_MIN_US 250u     // first step up from polling every rsp_poll
+#define RTT_PERIOD_MAX_US 20000u
+
+static rtt_stats_t g_rtt;
+static uint32_t    g_last_us = 0;
+static uint8_t     g_chunk[RTT_CHUNK];
+
+static uint32_t rtt_le32(const uint8_t *b)
+{
+    return (uint32_t) b[0] | ((uint32_t) b[1] << 8) | ((uint32_t) b[2] << 16) | ((uint32_t) b[3] << 24);
+}
+
+static bool rtt_write_u32(uint32_t addr, uint32_t v)
+{
+    uint8_t b[4] = {(uint8_t) v, (uint8_t) (v >> 8), (uint8_t) (v >> 16), (uint8_t) (v >> 24)};
+    return target_mem_write_bytes(addr, b, sizeof(b));
+}
+
+// pBuffer, SizeOfBuffer, WrOff, RdOff of one descriptor; false if it isn't usable.
+static bool rtt_read_desc(uint32_t desc, uint32_t d[4])
+{
+    uint8_t b[16];
+    if (!target_mem_read_bytes(desc + RTT_DESC_BUFFER, b, sizeof(b))) {
+        return false;
+    }
+    for (uint32_t i = 0; i < 4u; i++) {
+        d[i] = rtt_le32(&b[4u * i]);
+    }
+    return d[0] != 0u && d[1] != 0u && d[2] < d[1] && d[3] < d[1];
+}
+
+bool rtt_attach(uint32_t cb_addr)
+{
+    static const char k_id[] = "SEGGER RTT";
+    uint8_t           b[RTT_CB_BUFFERS];
+    if (!target_mem_read_bytes(cb_addr, b, sizeof(b))) {
+        return false;
+    }
+    for (uint32_t i = 0; i < sizeof(k_id); i++) {
+        if (b[i] != (uint8_t) k_id[i]) {
+            return false;
+        }
+    }
+    uint32_t up   = rtt_le32(&b[RTT_CB_NUM_UP]);
+    uint32_t down = rtt_le32(&b[RTT_CB_NUM_UP + 4u]);
+    if (up == 0u || up > RTT_MAX_BUFFERS || down > RTT_MAX_BUFFERS) {
+        return false;
+    }
+    g_rtt.addr       = cb_addr;
+    g_rtt.num_up     = up;
+    g_rtt.num_down   = down;
+    g_rtt.bytes_up   = 0;
+    g_rtt.bytes_down = 0;
+    g_rtt.period_us  = RTT_PERIOD_MIN_US;
+    g_last_us        = hal_time_us();
+    return true;
+}
+
+bool rtt_scan(uint32_t start, uint32_t size)
+{
+    uint32_t skip = (0u - start) & 3u;
+    if (size < skip) {
+        return false;
+    }
+    start += skip;
+    size -= skip;
+    for (uint32_t off = 0; off + RTT_CB_BUFFERS <= size; off += RTT_CHUNK) {
+        // The range may end at the top of RAM: don't read past it.
+        uint32_t n = (size - off < RTT_CHUNK) ? size - off : RTT_CHUNK;
+        if (!target_mem_read_bytes(start + off, g_chunk, n)) {
+            return false;
+        }
+        // The control block is word aligned; "SEGG" starts every candidate.
+        for (uint32_t i = 0; i + 4u <= n && off + i + RTT_CB_BUFFERS <= size; i += 4u) {
+            if (rtt_le32(&g_chunk[i]) == 0x47474553u && rtt_attach(start + off + i)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void rtt_detach(void) { g_rtt.addr = 0; }
+
+bool rtt_attached(void) { return g_rtt.addr != 0u; }
+
+void rtt_poll(bool force)
+{
+    if (!g_rtt.addr) {
+        return;
+    }
+    uint32_t now = hal_time_us();
+    if (!force && (now - g_last_us) < g_rtt.period_us) {
+        return;
+    }
+    g_last_us = now;
+
+    uint32_t budget = RTT_POLL_BUDGET;
+    uint32_t fill   = 0;  // fullest up-buffer seen: 0 empty, 1 some, 2 >= 1/8, 3 >= 1/2
+    uint32_t nup    = (g_rtt.num_up < RTT_MAX_UP) ? g_rtt.num_up : RTT_MAX_UP;
+    for (uint32_t ch = 0; ch < nup; ch++) {
+        uint32_t desc = g_rtt.addr + RTT_CB_BUFFERS + ch * RTT_DESC_SIZE;
+        uint32_t d[4];
+        if (!rtt_read_desc(desc, d)) {
+            continue;
+        }
+        uint32_t size = d[1];
+        uint32_t wr   = d[2];
+        uint32_t rd   = d[3];
+        uint32_t used = (wr >= rd) ? (wr - rd) : (size - rd + wr);
+        if (used == 0u) {
+            continue;
+        }
+        uint32_t f = (used >= size / 2u) ? 3u : ((used >= size / 8u) ? 2u : 1u);
+        if (f > fill) {
+            fill = f;
+        }
+
+        while (rd != wr && budget) {
+            uint32_t n = (wr > rd) ? (wr - rd) : (size - rd);  // contiguous part
+            if (n > RTT_CHUNK) {
+                n = RTT_CHUNK;
+            }
+            if (n > budget) {
+                n = budget;
+            }
+            if (!target_mem_read_bytes(d[0] + rd, g_chunk, n)) {
+                break;
+            }
+            rsp_console_write_bytes(g_chunk, n);
+            rd = (rd + n == size) ? 0u : (rd + n);
+            budget -= n;
+            g_rtt.bytes_up += n;
+        }
+        (void) rtt_write_u32(desc + RTT_DESC_RDOFF, rd);
+    }
+
+    // Poll every rsp_poll while a buffer is half full, speed up while data keeps
+    // coming, back off towards RTT_PERIOD_MAX_US once the target is quiet.
+    if (fill == 3u || budget == 0u) {
+        g_rtt.period_us = 0;
+    } else if (fill == 2u) {
+        g_rtt.period_us /= 2u;
+    } else if (fill == 0u) {
+        uint32_t p      = (g_rtt.period_us < RTT_PERIOD_MIN_US) ? RTT_PERIOD_MIN_US : (2u * g_rtt.period_us);
+        g_rtt.period_us = (p > RTT_PERIOD_MAX_US) ? RTT_PERIOD_MAX_US : p;
+    }
+}
+
+uint32_t rtt_write(const uint8_t *data, uint32_t len)
+{
+    if (!g_rtt.addr || g_rtt.num_down == 0u) {
+        return 0;
+    }
+    uint32_t desc = g_rtt.addr + RTT_CB_BUFFERS + g_rtt.num_up * RTT_DESC_SIZE;
+    uint32_t d[4];
+    if (!rtt_read_desc(desc, d)) {
+        return 0;
+    }
+    uint32_t size = d[1];
+    uint32_t wr   = d[2];
+    uint32_t rd   = d[3];
+    uint32_t done = 0;
+    while (done < len) {
+        // One slot stays free so that WrOff == RdOff means empty.
+        uint32_t space = (rd > wr) ? (rd - wr - 1u) : (size - wr - ((rd == 0u) ? 1u : 0u));
+        if (space == 0u) {
+            break;
+        }
+        if (space > len - done) {
+            space = len - done;
+        }
+        if (!target_mem_write_bytes(d[0] + wr, data + done, space)) {
+            break;
+        }
+        done += space;
+        wr = (wr + space == size) ? 0u : (wr + space);
+    }
+    if (done && !rtt_write_u32(desc + RTT_DESC_WROFF, wr)) {
+        return 0;
+    }
+    g_rtt.bytes_down += done;
+    return done;
+}
+
+void rtt_get(rtt_stats_t *out) { *out = g_rtt; }
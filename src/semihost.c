@@ -0,0 +1,325 @@
+// Semihosting on the probe (see semihost.h).
+
+#include "semihost.h"
+
+#include "hal.h"
+#include "rsp.h"
+#include "target.h"
+
+// ARM semihosting operations (also used by the RISC-V semihosting spec)
+#define SYS_OPEN          0x01u
+#define SYS_CLOSE         0x02u
+#define SYS_WRITEC        0x03u
+#define SYS_WRITE0        0x04u
+#define SYS_WRITE         0x05u
+#define SYS_READ          0x06u
+#define SYS_ISERROR       0x08u
+#define SYS_ISTTY         0x09u
+#define SYS_SEEK          0x0Au
+#define SYS_FLEN          0x0Cu
+#define SYS_REMOVE        0x0Eu
+#define SYS_RENAME        0x0Fu
+#define SYS_CLOCK         0x10u
+#define SYS_SYSTEM        0x12u
+#define SYS_ERRNO         0x13u
+#define SYS_GET_CMDLINE   0x15u
+#define SYS_HEAPINFO      0x16u
+#define SYS_EXIT          0x18u
+#define SYS_EXIT_EXTENDED 0x20u
+#define SYS_ELAPSED       0x30u
+#define SYS_TICKFREQ      0x31u
+
+#define ADP_STOPPED_APPLICATION_EXIT 0x20026u
+
+// GDB File-I/O open flags and the mode used for created files (0644)
+#define FIO_O_WRONLY 0x1u
+#define FIO_O_RDWR   0x2u
+#define FIO_O_APPEND 0x8u
+#define FIO_O_CREAT  0x200u
+#define FIO_O_TRUNC  0x400u
+#define FIO_MODE     0x1A4u
+
+#define SEMIHOST_WRITE0_MAX  1024u   // runaway guard for unterminated strings
+
+static uint32_t g_op      = 0;
+static uint32_t g_arg     = 0;
+static uint32_t g_p[4];            // parameter block
+static uint32_t g_step    = 0;     // SYS_FLEN: lseek sequence position
+static uint32_t g_pos     = 0;     // SYS_FLEN: file position to restore
+static uint32_t g_len     = 0;     // SYS_FLEN: file length
+static uint32_t g_errno   = 0;
+static uint8_t  g_exit    = 0;
+static char     g_req[64];
+static uint32_t g_req_len = 0;
+
+static rsp_console_line_t g_con;  // coalesced console output
+
+static bool con_from_target(uint32_t addr, uint32_t len, bool to_nul)
+{
+    uint8_t b[16];
+    while (len) {
+        uint32_t n = (len > sizeof(b)) ? (uint32_t) sizeof(b) : len;
+        if (!target_mem_read_bytes(addr, b, n)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (to_nul && b[i] == 0u) {
+                return true;
+            }
+            rsp_console_putc(&g_con, b[i]);
+        }
+        addr += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool write_u32(uint32_t addr, uint32_t v)
+{
+    uint8_t b[4] = {(uint8_t) v, (uint8_t) (v >> 8), (uint8_t) (v >> 16), (uint8_t) (v >> 24)};
+    return target_mem_write_bytes(addr, b, sizeof(b));
+}
+
+static void req_str(const char *s)
+{
+    while (*s && g_req_len < sizeof(g_req) - 1u) {
+        g_req[g_req_len++] = *s++;
+    }
+    g_req[g_req_len] = '\0';
+}
+
+static void req_hex(char sep, uint32_t v)
+{
+    char     buf[11];
+    uint32_t n = sizeof(buf) - 1u;
+    buf[n]     = '\0';
+    do {
+        buf[--n] = "0123456789abcdef"[v & 0xFu];
+        v >>= 4;
+    } while (v);
+    buf[--n] = sep;
+    req_str(&buf[n]);
+}
+
+// Starts a request; GDB path lengths include the terminating NUL.
+static semihost_status_t req_path(const char *call, uint32_t ptr, uint32_t len)
+{
+    g_req_len = 0;
+    req_str(call);
+    req_hex(',', ptr);
+    req_hex('/', len + 1u);
+    rsp_console_flush(&g_con);
+    return SEMIHOST_FILEIO;
+}
+
+static semihost_status_t req_fd(const char *call, uint32_t fd)
+{
+    g_req_len = 0;
+    req_str(call);
+    req_hex(',', fd);
+    rsp_console_flush(&g_con);
+    return SEMIHOST_FILEIO;
+}
+
+static semihost_status_t finish(uint32_t result)
+{
+    return target_semihost_return(result) ? SEMIHOST_RESUME : SEMIHOST_ERROR;
+}
+
+static uint32_t param_count(uint32_t op)
+{
+    switch (op) {
+        case SYS_CLOSE:
+        case SYS_ISERROR:
+        case SYS_ISTTY:
+        case SYS_FLEN:
+        case SYS_HEAPINFO:
+            return 1;
+        case SYS_SEEK:
+        case SYS_REMOVE:
+        case SYS_SYSTEM:
+        case SYS_GET_CMDLINE:
+        case SYS_EXIT_EXTENDED:
+            return 2;
+        case SYS_OPEN:
+        case SYS_WRITE:
+        case SYS_READ:
+            return 3;
+        case SYS_RENAME:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t open_flags(uint32_t mode)
+{
+    // ARM modes 0-11: r rb r+ r+b w wb w+ w+b a ab a+ a+b
+    uint32_t rw = (mode & 2u) ? FIO_O_RDWR : FIO_O_WRONLY;
+    switch (mode >> 2) {
+        case 0:
+            return (mode & 2u) ? FIO_O_RDWR : 0u;
+        case 1:
+            return rw | FIO_O_CREAT | FIO_O_TRUNC;
+        default:
+            return rw | FIO_O_CREAT | FIO_O_APPEND;
+    }
+}
+
+static semihost_status_t semihost_dispatch(void)
+{
+    uint8_t b[4];
+
+    switch (g_op) {
+        case SYS_OPEN:
+            // ":tt" is the console: stdin for read modes, stdout for w, stderr for a.
+            if (g_p[2] == 3u && target_mem_read_bytes(g_p[0], b, 4u) && b[0] == ':' && b[1] == 't' &&
+                b[2] == 't' && b[3] == 0u) {
+                return finish((g_p[1] < 4u) ? 0u : ((g_p[1] < 8u) ? 1u : 2u));
+            }
+            (void) req_path("Fopen", g_p[0], g_p[2]);
+            req_hex(',', open_flags(g_p[1]));
+            req_hex(',', FIO_MODE);
+            return SEMIHOST_FILEIO;
+        case SYS_CLOSE:
+            return (g_p[0] <= 2u) ? finish(0u) : req_fd("Fclose", g_p[0]);
+        case SYS_WRITEC:
+            return con_from_target(g_arg, 1u, false) ? finish(0u) : SEMIHOST_ERROR;
+        case SYS_WRITE0:
+            return con_from_target(g_arg, SEMIHOST_WRITE0_MAX, true) ? finish(0u) : SEMIHOST_ERROR;
+        case SYS_WRITE:
+            if (g_p[0] == 1u || g_p[0] == 2u) {
+                return con_from_target(g_p[1], g_p[2], false) ? finish(0u) : SEMIHOST_ERROR;
+            }
+            (void) req_fd("Fwrite", g_p[0]);
+            req_hex(',', g_p[1]);
+            req_hex(',', g_p[2]);
+            return SEMIHOST_FILEIO;
+        case SYS_READ:
+            (void) req_fd("Fread", g_p[0]);
+            req_hex(',', g_p[1]);
+            req_hex(',', g_p[2]);
+            return SEMIHOST_FILEIO;
+        case SYS_ISERROR:
+            return finish(((int32_t) g_p[0] < 0) ? 1u : 0u);
+        case SYS_ISTTY:
+            return (g_p[0] <= 2u) ? finish(1u) : req_fd("Fisatty", g_p[0]);
+        case SYS_SEEK:
+            (void) req_fd("Flseek", g_p[0]);
+            req_hex(',', g_p[1]);
+            req_hex(',', 0u);  // SEEK_SET
+            return SEMIHOST_FILEIO;
+        case SYS_FLEN:
+            // No buffer for Ffstat: lseek to the end and back (SEEK_CUR, SEEK_END, SEEK_SET).
+            if (g_p[0] <= 2u) {
+                return finish(0u);
+            }
+            (void) req_fd("Flseek", g_p[0]);
+            req_str(",0,1");
+            return SEMIHOST_FILEIO;
+        case SYS_REMOVE:
+            return req_path("Funlink", g_p[0], g_p[1]);
+        case SYS_RENAME:
+            (void) req_path("Frename", g_p[0], g_p[1]);
+            req_hex(',', g_p[2]);
+            req_hex('/', g_p[3] + 1u);
+            return SEMIHOST_FILEIO;
+        case SYS_SYSTEM:
+            return req_path("Fsystem", g_p[0], g_p[1]);
+        case SYS_CLOCK:
+            return finish(hal_time_us() / 10000u);  // centiseconds
+        case SYS_ERRNO:
+            return finish(g_errno);
+        case SYS_GET_CMDLINE:
+            // Empty command line.
+            b[0] = 0u;
+            return (g_p[1] && target_mem_write_bytes(g_p[0], b, 1u) && write_u32(g_arg + 4u, 0u)) ? finish(0u)
+                                                                                                 : finish(0xFFFFFFFFu);
+        case SYS_HEAPINFO:
+            // All zero: the C library falls back to its linker-script heap and stack.
+            for (uint32_t i = 0; i < 4u; i++) {
+                if (!write_u32(g_p[0] + 4u * i, 0u)) {
+                    return SEMIHOST_ERROR;
+                }
+            }
+            return finish(0u);
+        case SYS_EXIT:
+            g_exit = (g_arg == ADP_STOPPED_APPLICATION_EXIT) ? 0u : 1u;
+            rsp_console_flush(&g_con);
+            return SEMIHOST_EXIT;
+        case SYS_EXIT_EXTENDED:
+            g_exit = (g_p[0] == ADP_STOPPED_APPLICATION_EXIT) ? (uint8_t) g_p[1] : 1u;
+            rsp_console_flush(&g_con);
+            return SEMIHOST_EXIT;
+        case SYS_ELAPSED:
+            return (write_u32(g_arg, hal_time_us()) && write_u32(g_arg + 4u, 0u)) ? finish(0u) : SEMIHOST_ERROR;
+        case SYS_TICKFREQ:
+            return finish(1000000u);
+        default:
+            return finish(0xFFFFFFFFu);  // SYS_READC, SYS_TIME, SYS_TMPNAM, ...: unsupported
+    }
+}
+
+semihost_status_t semihost_on_halt(void)
+{
+    uint8_t b[16];
+
+    if (!target_semihost_pending(&g_op, &g_arg)) {
+        rsp_console_flush(&g_con);  // target output goes out before the stop reply
+        return SEMIHOST_NOT_MINE;
+    }
+    uint32_t n = param_count(g_op);
+    if (n && !target_mem_read_bytes(g_arg, b, 4u * n)) {
+        return SEMIHOST_ERROR;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        g_p[i] = (uint32_t) b[4u * i] | ((uint32_t) b[4u * i + 1u] << 8) | ((uint32_t) b[4u * i + 2u] << 16) |
+                 ((uint32_t) b[4u * i + 3u] << 24);
+    }
+    g_step = 0;
+    return semihost_dispatch();
+}
+
+semihost_status_t semihost_on_reply(int32_t ret, uint32_t err)
+{
+    if (ret < 0) {
+        g_errno = err;
+    }
+    switch (g_op) {
+        case SYS_WRITE:
+        case SYS_READ:
+            // Both return the number of bytes NOT transferred.
+            return finish((ret < 0) ? g_p[2] : (g_p[2] - (uint32_t) ret));
+        case SYS_SEEK:
+            return finish((ret < 0) ? 0xFFFFFFFFu : 0u);
+        case SYS_FLEN:
+            if (ret < 0) {
+                return finish(0xFFFFFFFFu);
+            }
+            if (g_step == 0u) {
+                g_pos = (uint32_t) ret;
+                (void) req_fd("Flseek", g_p[0]);
+                req_str(",0,2");
+            } else if (g_step == 1u) {
+                g_len = (uint32_t) ret;
+                (void) req_fd("Flseek", g_p[0]);
+                req_hex(',', g_pos);
+                req_str(",0");
+            } else {
+                return finish(g_len);
+            }
+            g_step++;
+            return SEMIHOST_FILEIO;
+        default:
+            return finish((uint32_t) ret);
+    }
+}
+
+const char *semihost_request(void) { return g_req; }
+
+uint8_t semihost_exit_code(void) { return g_exit; }
+
+void semihost_poll(void)
+{
+    rsp_console_poll(&g_con, false);
+}
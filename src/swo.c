@@ -0,0 +1,191 @@
+// SWO trace capture and ITM decoding (see swo.h).
+
+#include "swo.h"
+
+#include "cortex.h"
+#include "hal.h"
+#include "rsp.h"
+
+#define SWO_ACPR_MAX      0x1FFFu   // narrowest TPIU prescaler (13 bits on v7-M)
+#define SWO_POLL_BUDGET   512u      // bytes decoded per swo_poll, keeps rsp responsive
+
+// ITM header byte: bits[1:0] = payload size (0 = protocol packet), bit 2 = hardware
+// source, bits[7:3] = stimulus port or DWT discriminator.
+#define ITM_HDR_SIZE_MASK  0x03u
+#define ITM_HDR_HW         0x04u
+#define ITM_HDR_CONT       0x80u
+#define ITM_OVERFLOW       0x70u
+#define DWT_DISC_EXC_TRACE 1u
+#define DWT_EXC_FN_ENTER   1u
+
+static swo_stats_t g_swo;
+static uint8_t     g_hdr  = 0;
+static uint8_t     g_need = 0;      // payload bytes of the current source packet
+static uint8_t     g_got  = 0;
+static bool        g_cont = false;  // skipping a protocol packet's continuation bytes
+static uint8_t     g_pl[4];
+
+static rsp_console_line_t g_con;  // coalesced port 0 text
+
+static uint16_t g_exc_num[SWO_EXC_SLOTS];
+static uint32_t g_exc_count[SWO_EXC_SLOTS];
+static uint32_t g_exc_used = 0;
+
+static void exc_count(uint16_t num)
+{
+    for (uint32_t i = 0; i < g_exc_used; i++) {
+        if (g_exc_num[i] == num) {
+            g_exc_count[i]++;
+            return;
+        }
+    }
+    if (g_exc_used == SWO_EXC_SLOTS) {
+        g_swo.exc_other++;
+        return;
+    }
+    g_exc_num[g_exc_used]   = num;
+    g_exc_count[g_exc_used] = 1;
+    g_exc_used++;
+}
+
+static void swo_packet(void)
+{
+    uint8_t port = g_hdr >> 3;
+
+    if (!(g_hdr & ITM_HDR_HW)) {
+        if (port != 0u) {
+            g_swo.stimulus += g_need;
+            return;
+        }
+        // Word-sized writes of packed strings pad with NULs; drop them.
+        for (uint8_t i = 0; i < g_need; i++) {
+            if (g_pl[i]) {
+                rsp_console_putc(&g_con, g_pl[i]);
+                g_swo.text++;
+            }
+        }
+        return;
+    }
+    if (port == DWT_DISC_EXC_TRACE && g_need == 2u) {
+        // ExceptionNumber[8:0], then FUNCTION in bits [5:4] of the second byte.
+        if (((g_pl[1] >> 4) & 3u) == DWT_EXC_FN_ENTER) {
+            exc_count((uint16_t) (g_pl[0] | ((g_pl[1] & 1u) << 8)));
+        }
+    }
+    // Other DWT packets (event counters, PC samples, data trace) are not enabled.
+}
+
+static void swo_byte(uint8_t b)
+{
+    g_swo.bytes++;
+    if (g_cont) {
+        g_cont = (b & ITM_HDR_CONT) != 0u;
+        return;
+    }
+    if (g_need) {
+        g_pl[g_got++] = b;
+        if (g_got == g_need) {
+            swo_packet();
+            g_need = 0;
+        }
+        return;
+    }
+    if ((b & ITM_HDR_SIZE_MASK) == 0u) {
+        // Protocol packet: sync (zeros then 0x80), overflow, timestamps, extension.
+        if (b == ITM_OVERFLOW) {
+            g_swo.overflows++;
+        } else if (b != 0u && b != ITM_HDR_CONT) {
+            g_cont = (b & ITM_HDR_CONT) != 0u;
+        }
+        return;
+    }
+    g_hdr  = b;
+    g_need = ((b & ITM_HDR_SIZE_MASK) == 3u) ? 4u : (b & ITM_HDR_SIZE_MASK);
+    g_got  = 0;
+}
+
+bool swo_start(uint32_t trace_clk_hz, uint32_t baud, uint32_t port_mask, bool exc_trace)
+{
+    swo_stop();
+    if (baud == 0u || trace_clk_hz < baud) {
+        return false;
+    }
+    uint32_t div = (trace_clk_hz + baud / 2u) / baud;
+    if (div - 1u > SWO_ACPR_MAX) {
+        return false;
+    }
+
+    g_swo.prescaler = div - 1u;
+    g_swo.baud      = trace_clk_hz / div;
+    g_swo.port_mask = port_mask;
+    g_swo.exc_trace = exc_trace;
+    g_swo.bytes     = 0;
+    g_swo.text      = 0;
+    g_swo.stimulus  = 0;
+    g_swo.overflows = 0;
+    g_swo.dropped   = 0;
+    g_swo.exc_other = 0;
+    g_hdr      = 0;
+    g_need     = 0;
+    g_cont     = false;
+    g_con.len  = 0;
+    g_exc_used = 0;
+
+    // Capture first so nothing the target emits right after setup is lost.
+    if (!swo_uart_start(g_swo.baud)) {
+        return false;
+    }
+    if (!cortex_swo_enable(g_swo.prescaler, port_mask, exc_trace)) {
+        swo_uart_stop();
+        return false;
+    }
+    g_swo.running = true;
+    return true;
+}
+
+void swo_stop(void)
+{
+    if (!g_swo.running) {
+        return;
+    }
+    g_swo.running = false;
+    g_swo.dropped = swo_uart_dropped();
+    (void) cortex_swo_disable();
+    swo_uart_stop();
+    rsp_console_flush(&g_con);
+}
+
+bool swo_running(void) { return g_swo.running; }
+
+void swo_poll(bool force)
+{
+    if (!g_swo.running) {
+        return;
+    }
+    for (uint32_t n = 0; n < SWO_POLL_BUDGET; n++) {
+        int c = swo_getc();
+        if (c < 0) {
+            break;
+        }
+        swo_byte((uint8_t) c);
+    }
+    rsp_console_poll(&g_con, force);
+}
+
+void swo_get(swo_stats_t *out)
+{
+    *out = g_swo;
+    if (g_swo.running) {
+        out->dropped = swo_uart_dropped();
+    }
+}
+
+bool swo_exc_get(uint32_t i, uint32_t *out_num, uint32_t *out_count)
+{
+    if (i >= g_exc_used) {
+        return false;
+    }
+    *out_num   = g_exc_num[i];
+    *out_count = g_exc_count[i];
+    return true;
+}
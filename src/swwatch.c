@@ -0,0 +1,196 @@
+// Probe-side software watchpoint engine (single-step and compare on the probe).
+
+#include "swwatch.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "hal.h"
+#include "rsp.h"
+
+#define SWWATCH_MAX     4u
+#define SWWATCH_MAX_LEN 16u
+// Steps per swwatch_run() call; bounds Ctrl-C latency since UART is polled in between.
+#define SWWATCH_BATCH   32u
+
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+    uint8_t  data[SWWATCH_MAX_LEN];  // last seen contents
+    bool     used;
+} swwatch_t;
+
+static swwatch_t g_swwatch[SWWATCH_MAX];
+static bool      g_running    = false;
+static bool      g_first_step = false;
+static uint32_t  g_steps      = 0;
+static uint32_t  g_start_us   = 0;
+
+static swwatch_t *swwatch_find(uint32_t addr, uint32_t len)
+{
+    for (uint32_t i = 0; i < SWWATCH_MAX; i++) {
+        if (g_swwatch[i].used && g_swwatch[i].addr == addr && g_swwatch[i].len == len) {
+            return &g_swwatch[i];
+        }
+    }
+    return NULL;
+}
+
+bool swwatch_insert(target_watch_t type, uint32_t addr, uint32_t len)
+{
+    if (len == 0u) {
+        len = 1u;
+    }
+    if (type != TARGET_WATCH_WRITE || len > SWWATCH_MAX_LEN) {
+        return false;
+    }
+    if (swwatch_find(addr, len)) {
+        return true;
+    }
+    for (uint32_t i = 0; i < SWWATCH_MAX; i++) {
+        if (!g_swwatch[i].used) {
+            if (!target_mem_read_bytes(addr, g_swwatch[i].data, len)) {
+                return false;
+            }
+            g_swwatch[i].addr = addr;
+            g_swwatch[i].len  = len;
+            g_swwatch[i].used = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool swwatch_remove(target_watch_t type, uint32_t addr, uint32_t len)
+{
+    if (len == 0u) {
+        len = 1u;
+    }
+    swwatch_t *w = (type == TARGET_WATCH_WRITE) ? swwatch_find(addr, len) : NULL;
+    if (!w) {
+        return false;
+    }
+    w->used = false;
+    return true;
+}
+
+bool swwatch_active(void)
+{
+    for (uint32_t i = 0; i < SWWATCH_MAX; i++) {
+        if (g_swwatch[i].used) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool swwatch_start(void)
+{
+    // Memory may have been written by GDB while halted; compare against the current contents.
+    for (uint32_t i = 0; i < SWWATCH_MAX; i++) {
+        if (g_swwatch[i].used && !target_mem_read_bytes(g_swwatch[i].addr, g_swwatch[i].data, g_swwatch[i].len)) {
+            return false;
+        }
+    }
+    g_running    = true;
+    g_first_step = true;
+    g_steps      = 0;
+    g_start_us   = hal_time_us();
+    return true;
+}
+
+bool swwatch_running(void) { return g_running; }
+
+static char *swwatch_put_dec(char *p, uint32_t v)
+{
+    char     tmp[10];
+    uint32_t n = 0;
+    do {
+        tmp[n++] = (char) ('0' + (v % 10u));
+        v /= 10u;
+    } while (v);
+    while (n) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+// "swwatch: <steps> steps, <rate> steps/s" on the GDB console.
+static void swwatch_report(void)
+{
+    uint32_t ms   = (hal_time_us() - g_start_us) / 1000u;
+    uint32_t rate = ms ? (g_steps / ms) * 1000u + ((g_steps % ms) * 1000u) / ms : 0u;
+
+    char  line[48] = "swwatch: ";
+    char *p        = line + strlen(line);
+    p              = swwatch_put_dec(p, g_steps);
+    memcpy(p, " steps, ", 8u);
+    p = swwatch_put_dec(p + 8, rate);
+    memcpy(p, " steps/s\n", 10u);
+    rsp_console_write(line);
+}
+
+void swwatch_stop(void)
+{
+    if (g_running) {
+        g_running = false;
+        swwatch_report();
+    }
+}
+
+swwatch_status_t swwatch_run(target_watch_t *out_type, uint32_t *out_addr)
+{
+    if (!g_running) {
+        return SWWATCH_ERROR;
+    }
+
+    for (uint32_t n = 0; n < SWWATCH_BATCH; n++) {
+        // A breakpoint at the resume PC is the one GDB is continuing from; stop at any later one.
+        uint32_t pc = 0;
+        if (!target_read_pc(&pc)) {
+            swwatch_stop();
+            return SWWATCH_ERROR;
+        }
+        if (!g_first_step && target_breakpoint_at(pc)) {
+            swwatch_stop();
+            return SWWATCH_BREAK;
+        }
+        g_first_step = false;
+
+        if (!target_step()) {
+            swwatch_stop();
+            return SWWATCH_ERROR;
+        }
+        g_steps++;
+
+        // Hardware watchpoints still fire while stepping.
+        if (target_watchpoint_hit(out_type, out_addr)) {
+            swwatch_stop();
+            return SWWATCH_HIT;
+        }
+
+        for (uint32_t i = 0; i < SWWATCH_MAX; i++) {
+            swwatch_t *w = &g_swwatch[i];
+            uint8_t    now[SWWATCH_MAX_LEN];
+            if (!w->used) {
+                continue;
+            }
+            if (!target_mem_read_bytes(w->addr, now, w->len)) {
+                swwatch_stop();
+                return SWWATCH_ERROR;
+            }
+            if (memcmp(now, w->data, w->len) != 0) {
+                memcpy(w->data, now, w->len);
+                if (out_type) {
+                    *out_type = TARGET_WATCH_WRITE;
+                }
+                if (out_addr) {
+                    *out_addr = w->addr;
+                }
+                swwatch_stop();
+                return SWWATCH_HIT;
+            }
+        }
+    }
+    return SWWATCH_RUNNING;
+}
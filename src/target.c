@@ -4,8 +4,11 @@
 
 #include "target.h"
 
+#include <stddef.h>
+
 #if defined(PROBE_ENABLE_CORTEXM) && (PROBE_ENABLE_CORTEXM)
 #include "cortex.h"
+#include "target_mem.h"
 #define HAVE_CORTEXM 1
 #else
 #define HAVE_CORTEXM 0
@@ -26,6 +29,32 @@ typedef enum {
 
 static target_arch_t g_target_arch = TARGET_ARCH_NONE;
 
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+#define TARGET_WATCH_VALUE_MAX 2u
+
+typedef struct {
+    uint32_t addr;
+    uint32_t value;
+    bool     used;
+} target_watch_value_t;
+
+static target_watch_value_t g_watch_values[TARGET_WATCH_VALUE_MAX];
+#endif
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+#define TARGET_PROBE_BKPT_MAX 2u
+
+// Breakpoints the probe sets for itself. GDB may insert and remove its own at the same
+// address at any time; the hardware breakpoint stays until neither side wants it.
+typedef struct {
+    uint32_t addr;
+    bool     used;
+    bool     gdb;  // GDB also has a breakpoint here
+} target_probe_bkpt_t;
+
+static target_probe_bkpt_t g_probe_bkpts[TARGET_PROBE_BKPT_MAX];
+#endif
+
 void target_init(void)
 {
     g_target_arch = TARGET_ARCH_NONE;
@@ -80,7 +109,7 @@ bool target_continue(void)
     }
 }
 
-bool target_step(void)
+static bool target_arch_step(void)
 {
     switch (g_target_arch) {
 #if HAVE_CORTEXM
@@ -144,6 +173,23 @@ bool target_write_reg(uint32_t regnum, uint32_t val)
     }
 }
 
+bool target_read_pc(uint32_t *out)
+{
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_read_core_reg(15, out);
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            return riscv_read_reg(32, out);
+#endif
+        default:
+            (void)out;
+            return false;
+    }
+}
+
 uint32_t target_gdb_reg_count(void)
 {
     switch (g_target_arch) {
@@ -214,9 +260,14 @@ void target_breakpoints_init(void)
         default:
             break;
     }
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    for (uint32_t i = 0; i < TARGET_PROBE_BKPT_MAX; i++) {
+        g_probe_bkpts[i].used = false;
+    }
+#endif
 }
 
-bool target_breakpoint_insert(uint32_t addr)
+static bool target_arch_breakpoint_insert(uint32_t addr)
 {
     switch (g_target_arch) {
 #if HAVE_CORTEXM
@@ -233,7 +284,7 @@ bool target_breakpoint_insert(uint32_t addr)
     }
 }
 
-bool target_breakpoint_remove(uint32_t addr)
+static bool target_arch_breakpoint_remove(uint32_t addr)
 {
     switch (g_target_arch) {
 #if HAVE_CORTEXM
@@ -250,6 +301,132 @@ bool target_breakpoint_remove(uint32_t addr)
     }
 }
 
+static bool target_arch_breakpoint_at(uint32_t addr)
+{
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_breakpoint_at(addr);
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            return riscv_breakpoint_at(addr);
+#endif
+        default:
+            (void)addr;
+            return false;
+    }
+}
+
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+static target_probe_bkpt_t *target_probe_bkpt_find(uint32_t addr)
+{
+    for (uint32_t i = 0; i < TARGET_PROBE_BKPT_MAX; i++) {
+        if (g_probe_bkpts[i].used && g_probe_bkpts[i].addr == (addr & ~1u)) {
+            return &g_probe_bkpts[i];
+        }
+    }
+    return NULL;
+}
+#endif
+
+bool target_breakpoint_insert(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    target_probe_bkpt_t *b = target_probe_bkpt_find(addr);
+    if (b) {
+        b->gdb = true;
+        return true;
+    }
+#endif
+    return target_arch_breakpoint_insert(addr);
+}
+
+bool target_breakpoint_remove(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    target_probe_bkpt_t *b = target_probe_bkpt_find(addr);
+    if (b) {
+        b->gdb = false;
+        return true;
+    }
+#endif
+    return target_arch_breakpoint_remove(addr);
+}
+
+bool target_breakpoint_at(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    target_probe_bkpt_t *b = target_probe_bkpt_find(addr);
+    if (b) {
+        return b->gdb;
+    }
+#endif
+    return target_arch_breakpoint_at(addr);
+}
+
+bool target_probe_breakpoint_insert(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    target_probe_bkpt_t *b = NULL;
+    if (target_probe_bkpt_find(addr)) {
+        return false;
+    }
+    for (uint32_t i = 0; !b && i < TARGET_PROBE_BKPT_MAX; i++) {
+        if (!g_probe_bkpts[i].used) {
+            b = &g_probe_bkpts[i];
+        }
+    }
+    if (!b) {
+        return false;
+    }
+    // GDB's breakpoint (always-inserted mode) is adopted rather than installed twice.
+    bool gdb = target_arch_breakpoint_at(addr);
+    if (!gdb && !target_arch_breakpoint_insert(addr)) {
+        return false;
+    }
+    b->addr = addr & ~1u;
+    b->gdb  = gdb;
+    b->used = true;
+    return true;
+#else
+    (void)addr;
+    return false;
+#endif
+}
+
+bool target_probe_breakpoint_remove(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    target_probe_bkpt_t *b = target_probe_bkpt_find(addr);
+    if (!b) {
+        return true;
+    }
+    b->used = false;
+    return b->gdb || target_arch_breakpoint_remove(addr);
+#else
+    (void)addr;
+    return true;
+#endif
+}
+
+bool target_step(void)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    // A probe breakpoint under the PC would stop the step before it executes anything.
+    uint32_t pc  = 0;
+    bool     any = false;
+    for (uint32_t i = 0; i < TARGET_PROBE_BKPT_MAX; i++) {
+        any = any || g_probe_bkpts[i].used;
+    }
+    if (any && target_read_pc(&pc) && target_probe_bkpt_find(pc)) {
+        bool ok = target_arch_breakpoint_remove(pc) && target_arch_step();
+        return target_arch_breakpoint_insert(pc) && ok;
+    }
+#endif
+    return target_arch_step();
+}
+
 bool target_watchpoints_supported(void)
 {
     switch (g_target_arch) {
@@ -325,19 +502,210 @@ bool target_watchpoint_hit(target_watch_t *out_type, uint32_t *out_addr)
     }
 }
 
-bool target_mem_read_bytes(uint32_t addr, uint8_t *buf, uint32_t len)
+bool target_watchpoint_filtered(void)
 {
     switch (g_target_arch) {
 #if HAVE_CORTEXM
-        case TARGET_ARCH_CORTEX_M: {
-            // Use target_mem module for Cortex-M
-            extern bool target_mem_read_bytes_impl(uint32_t addr, uint8_t *buf, uint32_t len);
-            return target_mem_read_bytes_impl(addr, buf, len);
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_watchpoint_filtered();
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            return riscv_watchpoint_filtered();
+#endif
+        default:
+            return false;
+    }
+}
+
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+static target_watch_value_t *target_watch_value_find(uint32_t addr)
+{
+    for (uint32_t i = 0; i < TARGET_WATCH_VALUE_MAX; i++) {
+        if (g_watch_values[i].used && g_watch_values[i].addr == addr) {
+            return &g_watch_values[i];
         }
+    }
+    return NULL;
+}
+#endif
+
+bool target_watch_value_set(uint32_t addr, uint32_t value)
+{
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+    target_watch_value_t *v = target_watch_value_find(addr);
+    for (uint32_t i = 0; !v && i < TARGET_WATCH_VALUE_MAX; i++) {
+        if (!g_watch_values[i].used) {
+            v = &g_watch_values[i];
+        }
+    }
+    if (!v) {
+        return false;
+    }
+    v->addr  = addr;
+    v->value = value;
+    v->used  = true;
+    return true;
+#else
+    (void)addr; (void)value;
+    return false;
+#endif
+}
+
+bool target_watch_value_clear(uint32_t addr)
+{
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+    target_watch_value_t *v = target_watch_value_find(addr);
+    if (!v) {
+        return false;
+    }
+    v->used = false;
+    return true;
+#else
+    (void)addr;
+    return false;
+#endif
+}
+
+bool target_watch_value_lookup(uint32_t addr, uint32_t *out_value)
+{
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+    target_watch_value_t *v = target_watch_value_find(addr);
+    if (!v) {
+        return false;
+    }
+    *out_value = v->value;
+    return true;
+#else
+    (void)addr; (void)out_value;
+    return false;
+#endif
+}
+
+bool target_watch_value_get(uint32_t idx, uint32_t *out_addr, uint32_t *out_value)
+{
+#if defined(PROBE_ENABLE_VALUE_WATCHPOINTS) && (PROBE_ENABLE_VALUE_WATCHPOINTS)
+    // idx counts used entries only, so callers can iterate until this returns false.
+    for (uint32_t i = 0; i < TARGET_WATCH_VALUE_MAX; i++) {
+        if (!g_watch_values[i].used) {
+            continue;
+        }
+        if (idx-- == 0u) {
+            *out_addr  = g_watch_values[i].addr;
+            *out_value = g_watch_values[i].value;
+            return true;
+        }
+    }
+    return false;
+#else
+    (void)idx; (void)out_addr; (void)out_value;
+    return false;
+#endif
+}
+
+bool target_sample_pc(uint32_t *out)
+{
+#if defined(PROBE_ENABLE_PROFILE) && (PROBE_ENABLE_PROFILE)
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_sample_pc(out);
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            return riscv_sample_pc(out);
+#endif
+        default:
+            return false;
+    }
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+bool target_cycle_count(uint32_t *out)
+{
+#if defined(PROBE_ENABLE_REGION_TIMING) && (PROBE_ENABLE_REGION_TIMING)
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_cycle_count(out);
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            return riscv_cycle_count(out);
+#endif
+        default:
+            return false;
+    }
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+bool target_semihost_pending(uint32_t *out_op, uint32_t *out_arg)
+{
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_semihost_pending(out_op, out_arg);
 #endif
 #if HAVE_RISCV
         case TARGET_ARCH_RISCV:
-            return riscv_mem_read(addr, buf, len);
+            return riscv_semihost_pending(out_op, out_arg);
+#endif
+        default:
+            return false;
+    }
+#else
+    (void)out_op; (void)out_arg;
+    return false;
+#endif
+}
+
+bool target_semihost_return(uint32_t result)
+{
+#if defined(PROBE_ENABLE_SEMIHOSTING) && (PROBE_ENABLE_SEMIHOSTING)
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            return cortex_semihost_return(result);
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            return riscv_semihost_return(result);
+#endif
+        default:
+            return false;
+    }
+#else
+    (void)result;
+    return false;
+#endif
+}
+
+bool target_mem_read_bytes(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    switch (g_target_arch) {
+#if HAVE_CORTEXM
+        case TARGET_ARCH_CORTEX_M:
+            // Use target_mem module for Cortex-M; hide any patched BKPTs from the caller.
+            if (!target_mem_read_bytes_impl(addr, buf, len)) {
+                return false;
+            }
+            cortex_sw_breakpoints_mask_read(addr, buf, len);
+            return true;
+#endif
+#if HAVE_RISCV
+        case TARGET_ARCH_RISCV:
+            if (!riscv_mem_read(addr, buf, len)) {
+                return false;
+            }
+            riscv_sw_breakpoints_mask_read(addr, buf, len);
+            return true;
 #endif
         default:
             (void)addr; (void)buf; (void)len;
@@ -349,14 +717,20 @@ bool target_mem_write_bytes(uint32_t addr, const uint8_t *buf, uint32_t len)
 {
     switch (g_target_arch) {
 #if HAVE_CORTEXM
-        case TARGET_ARCH_CORTEX_M: {
-            extern bool target_mem_write_bytes_impl(uint32_t addr, const uint8_t *buf, uint32_t len);
-            return target_mem_write_bytes_impl(addr, buf, len);
-        }
+        case TARGET_ARCH_CORTEX_M:
+            if (!target_mem_write_bytes_impl(addr, buf, len)) {
+                return false;
+            }
+            cortex_sw_breakpoints_after_write(addr, buf, len);
+            return true;
 #endif
 #if HAVE_RISCV
         case TARGET_ARCH_RISCV:
-            return riscv_mem_write(addr, buf, len);
+            if (!riscv_mem_write(addr, buf, len)) {
+                return false;
+            }
+            riscv_sw_breakpoints_after_write(addr, buf, len);
+            return true;
 #endif
         default:
             (void)addr; (void)buf; (void)len;
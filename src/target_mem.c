@@ -72,9 +72,45 @@ bool target_mem_write_word(uint32_t addr, uint32_t v)
     return target_mem_write_word_ap(g_memap_ap_sel, addr, v);
 }
 
+bool target_mem_read_block(uint32_t addr, uint32_t *out, uint32_t count)
+{
+    if (!memap_set_csw_ap(g_memap_ap_sel, CSW_DEFAULT | CSW_ADDRINC_SINGLE | CSW_SIZE_32)) {
+        return false;
+    }
+    addr &= ~3u;
+    for (uint32_t i = 0; i < count; i++, addr += 4u) {
+        // TAR auto-increment is only guaranteed within a 1KB block.
+        if ((i == 0u || (addr & 0x3FFu) == 0u) && !memap_set_tar_ap(g_memap_ap_sel, addr)) {
+            return false;
+        }
+        if (!memap_read_drw_ap(g_memap_ap_sel, &out[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool target_mem_read_bytes_impl(uint32_t addr, uint8_t *buf, uint32_t len)
 {
     while (len) {
+        // Fast path: runs of aligned words stream from DRW with one TAR write.
+        if ((addr & 3u) == 0u && len >= 8u) {
+            uint32_t w[8];
+            uint32_t n = (len / 4u > 8u) ? 8u : (len / 4u);
+            if (!target_mem_read_block(addr, w, n)) {
+                return false;
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                *buf++ = (uint8_t) (w[i] & 0xFFu);
+                *buf++ = (uint8_t) ((w[i] >> 8) & 0xFFu);
+                *buf++ = (uint8_t) ((w[i] >> 16) & 0xFFu);
+                *buf++ = (uint8_t) ((w[i] >> 24) & 0xFFu);
+            }
+            addr += 4u * n;
+            len -= 4u * n;
+            continue;
+        }
+
         uint32_t aligned = addr & ~3u;
         uint32_t w       = 0;
         if (!target_mem_read_word(aligned, &w)) {
@@ -0,0 +1,216 @@
+// Host test for the LZ codec (see lz.h): every buffer is compressed through
+// lz_read_*, checked against a reference decoder written from the stream format alone,
+// then fed back through lz_write_feed() in pieces split at arbitrary points.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz.h"
+
+#define MEM_SIZE  0x11000u
+#define ZBUF_SIZE (MEM_SIZE + MEM_SIZE / LZ_MAX_RUN + 16u)
+
+static uint8_t  g_src[MEM_SIZE];  // "target memory" read by the compressor
+static uint8_t  g_dst[MEM_SIZE];  // "target memory" written by the decoder
+static uint8_t  g_z[ZBUF_SIZE];
+static uint8_t  g_ref[MEM_SIZE];
+static uint32_t g_rng = 1u;
+static int      g_failed;
+
+bool target_mem_read_bytes(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (addr > MEM_SIZE || len > MEM_SIZE - addr) {
+        return false;
+    }
+    memcpy(buf, &g_src[addr], len);
+    return true;
+}
+
+bool target_mem_write_bytes(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    if (addr > MEM_SIZE || len > MEM_SIZE - addr) {
+        return false;
+    }
+    memcpy(&g_dst[addr], buf, len);
+    return true;
+}
+
+static uint32_t rng(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+// Reference decoder: false unless the stream decodes to exactly len bytes.
+static bool ref_decode(const uint8_t *z, uint32_t zlen, uint8_t *out, uint32_t len)
+{
+    uint32_t i = 0;
+    uint32_t o = 0;
+    while (i < zlen) {
+        uint8_t t = z[i++];
+        if (t < 0x80u) {
+            uint32_t n = t + 1u;
+            if (n > zlen - i || n > len - o) {
+                return false;
+            }
+            memcpy(&out[o], &z[i], n);
+            i += n;
+            o += n;
+        } else {
+            if (i == zlen) {
+                return false;
+            }
+            uint32_t n    = (t & 0x7Fu) + LZ_MIN_MATCH;
+            uint32_t dist = z[i++] + 1u;
+            if (dist > o || n > len - o) {
+                return false;
+            }
+            for (uint32_t k = 0; k < n; k++, o++) {
+                out[o] = out[o - dist];
+            }
+        }
+    }
+    return o == len;
+}
+
+static uint32_t compress(uint32_t addr, uint32_t len)
+{
+    uint32_t zlen = 0;
+    int      c;
+    lz_read_start(addr, len);
+    while ((c = lz_read_peek()) >= 0) {
+        if (zlen == ZBUF_SIZE) {
+            return ZBUF_SIZE + 1u;
+        }
+        g_z[zlen++] = (uint8_t) c;
+        lz_read_skip();
+    }
+    return (c == -1) ? zlen : ZBUF_SIZE + 1u;
+}
+
+// Feed the stream in pieces of 1..max_piece bytes (0: all at once).
+static bool decompress(uint32_t addr, uint32_t len, uint32_t zlen, uint32_t max_piece)
+{
+    uint32_t off = 0;
+    lz_write_start(addr, len);
+    while (off < zlen) {
+        uint32_t n = max_piece ? 1u + rng() % max_piece : zlen;
+        if (n > zlen - off) {
+            n = zlen - off;
+        }
+        if (!lz_write_matches(addr, len, off) || !lz_write_feed(&g_z[off], n)) {
+            return false;
+        }
+        off += n;
+    }
+    return lz_write_done() == len;
+}
+
+static void check(const char *what, uint32_t addr, uint32_t len, uint32_t max_piece)
+{
+    uint32_t zlen = compress(addr, len);
+    if (zlen > ZBUF_SIZE) {
+        printf("FAIL %s: compress addr=0x%x len=%u\n", what, addr, len);
+        g_failed++;
+        return;
+    }
+    if (!ref_decode(g_z, zlen, g_ref, len) || memcmp(g_ref, &g_src[addr], len) != 0) {
+        printf("FAIL %s: reference decode addr=0x%x len=%u zlen=%u\n", what, addr, len, zlen);
+        g_failed++;
+        return;
+    }
+    memset(g_dst, 0xA5, sizeof(g_dst));
+    if (!decompress(addr, len, zlen, max_piece) || memcmp(&g_dst[addr], &g_src[addr], len) != 0) {
+        printf("FAIL %s: lz_write_feed addr=0x%x len=%u zlen=%u piece=%u\n", what, addr, len, zlen, max_piece);
+        g_failed++;
+        return;
+    }
+    if ((addr != 0u && g_dst[addr - 1u] != 0xA5u) || (addr + len < MEM_SIZE && g_dst[addr + len] != 0xA5u)) {
+        printf("FAIL %s: write outside [0x%x, +%u)\n", what, addr, len);
+        g_failed++;
+    }
+}
+
+static void fill(int kind)
+{
+    switch (kind) {
+        case 0:  // zeroes
+            memset(g_src, 0, sizeof(g_src));
+            break;
+        case 1:  // random
+            for (uint32_t i = 0; i < MEM_SIZE; i++) {
+                g_src[i] = (uint8_t) rng();
+            }
+            break;
+        case 2:  // repeated word
+            for (uint32_t i = 0; i < MEM_SIZE; i++) {
+                g_src[i] = (uint8_t) (0xDEADBEEFu >> (8u * (i & 3u)));
+            }
+            break;
+        case 3:  // sparse: mostly zero with scattered values
+            memset(g_src, 0, sizeof(g_src));
+            for (uint32_t i = 0; i < MEM_SIZE / 16u; i++) {
+                g_src[rng() % MEM_SIZE] = (uint8_t) rng();
+            }
+            break;
+        default:  // short runs with occasional noise, and a random stretch
+            for (uint32_t i = 0; i < MEM_SIZE; i++) {
+                g_src[i] = (uint8_t) ("abcabcd"[i % 7u] ^ ((rng() % 50u == 0u) ? 0x20u : 0u));
+            }
+            for (uint32_t i = 0x4000u; i < 0x4800u; i++) {
+                g_src[i] = (uint8_t) rng();
+            }
+            break;
+    }
+}
+
+static void check_malformed(void)
+{
+    static const uint8_t k_far[]  = {0x00u, 0x11u, 0x80u, 0x01u};  // distance 2 after 1 byte
+    static const uint8_t k_long[] = {0x03u, 1u, 2u, 3u, 4u};        // 4 literals for a 3-byte write
+    uint8_t              dangling = 0x81u;                          // match waiting for its distance
+
+    lz_write_start(0u, 16u);
+    if (lz_write_feed(k_far, sizeof(k_far)) || lz_write_matches(0u, 16u, sizeof(k_far))) {
+        printf("FAIL malformed: distance past the start accepted\n");
+        g_failed++;
+    }
+    lz_write_start(0u, 3u);
+    if (lz_write_feed(k_long, sizeof(k_long))) {
+        printf("FAIL malformed: output past len accepted\n");
+        g_failed++;
+    }
+    lz_write_start(0u, 4u);
+    if (!lz_write_feed(&dangling, 1u) || lz_write_done() != 0u) {
+        printf("FAIL malformed: token split before its distance byte\n");
+        g_failed++;
+    }
+}
+
+int main(void)
+{
+    static const uint32_t k_lens[] = {1u, 2u, 3u, 4u, 127u, 128u, 129u, 255u, 256u, 257u, 4096u, 0x10000u};
+    int                   cases    = 0;
+
+    for (int kind = 0; kind < 5; kind++) {
+        fill(kind);
+        for (uint32_t i = 0; i < sizeof(k_lens) / sizeof(k_lens[0]); i++) {
+            check("edge", 0x101u, k_lens[i], 0u);
+            check("edge", 0x101u, k_lens[i], 1u);
+            cases += 2;
+        }
+        for (int n = 0; n < 80; n++) {
+            uint32_t len  = 1u + rng() % 0x10000u;
+            uint32_t addr = rng() % (MEM_SIZE - len + 1u);
+            check("random", addr, len, 1u + rng() % 300u);
+            cases++;
+        }
+    }
+    check_malformed();
+
+    printf("%s: %d round trips\n", g_failed ? "FAILED" : "OK", cases);
+    return g_failed ? 1 : 0;
+}